@@ -0,0 +1,184 @@
+#ifndef RXBEE_AWAITABLE_H
+#define RXBEE_AWAITABLE_H
+
+// C++20 coroutine support. Only available when the compiler implements
+// coroutines, the rest of the library does not depend on it.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define RXBEE_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifndef RXBEE_HAS_COROUTINES
+#define RXBEE_HAS_COROUTINES 0
+#endif
+
+#if RXBEE_HAS_COROUTINES
+
+#include <coroutine>
+#include <exception>
+
+#include "Transaction.h"
+#include "SpecificResponses.h"
+
+namespace RXBee
+{
+
+struct TransactionResult
+{
+    Transaction::Error error;
+
+    // Response frame, valid until the coroutine suspends again
+    Frame* frame;
+};
+
+// Suspends the awaiting coroutine until the last transaction of a chain
+// completes. Resumption happens inside XBeeNetwork::Service. The awaiter
+// lives in the coroutine frame, so nothing else is allocated.
+//
+// With pend the chain is pended once the completion handler is
+// registered, which is required when the coroutine does not run on the
+// Service thread of a RXBEE_THREADED build. An awaiter destroyed without
+// suspending pends the chain anyway, so it is sent and freed by Service.
+class TransactionAwaiter
+{
+public:
+    explicit TransactionAwaiter(Transaction* t, bool pend = false)
+        : transaction(t), pend(pend), suspended(false)
+    {
+        while ((transaction != NULL) && (transaction->GetNext() != NULL))
+        {
+            transaction = transaction->GetNext();
+        }
+    }
+
+    TransactionAwaiter(TransactionAwaiter&& other) noexcept
+        : transaction(other.transaction), pend(other.pend), suspended(other.suspended)
+    {
+        other.transaction = NULL;
+    }
+
+    TransactionAwaiter(const TransactionAwaiter&) = delete;
+    TransactionAwaiter& operator=(const TransactionAwaiter&) = delete;
+
+    ~TransactionAwaiter()
+    {
+        if (pend && !suspended && (transaction != NULL))
+        {
+            transaction->Pend();
+        }
+    }
+
+    bool await_ready() const noexcept
+    {
+        return transaction == NULL;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        handle = h;
+        suspended = true;
+        transaction->OnComplete(Resume, this);
+        if (pend)
+        {
+            transaction->Pend();
+        }
+    }
+
+    TransactionResult await_resume() const noexcept
+    {
+        TransactionResult result;
+        result.error = Transaction::Error::INVALID_TRANSACTION_STATE;
+        result.frame = NULL;
+
+        if (transaction != NULL)
+        {
+            result.error = transaction->GetError();
+            result.frame = transaction->GetFrame();
+        }
+        return result;
+    }
+
+protected:
+    static void Resume(Transaction*, void* context)
+    {
+        static_cast<TransactionAwaiter*>(context)->handle.resume();
+    }
+
+    Transaction* transaction;
+    bool pend;
+    bool suspended;
+    std::coroutine_handle<> handle;
+};
+
+template<typename T>
+struct ATResult
+{
+    Transaction::Error error;
+    Response::ATCommand::Status status;
+    T value;
+};
+
+// Awaits an AT query and extracts the typed response for command C
+template<XBeeATCommand C>
+class [[nodiscard]] ATReadAwaiter : public TransactionAwaiter
+{
+public:
+    typedef typename Response::ATCommand::Accessor<C>::Type Type;
+
+    // t is pended when the coroutine suspends
+    explicit ATReadAwaiter(Transaction* t) : TransactionAwaiter(t, true) {}
+
+    ATResult<Type> await_resume() const
+    {
+        ATResult<Type> result;
+        TransactionResult r = TransactionAwaiter::await_resume();
+
+        result.error = r.error;
+        result.status = Response::ATCommand::Status::INVALID_STATUS;
+        result.value = Type();
+
+        // On error the frame may still be the request
+        if (r.error == Transaction::Error::NONE)
+        {
+            Response::ApiFrame api_frame(r.frame);
+            Response::ATCommand::Response rsp(api_frame);
+            result.status = rsp.status;
+            result.value = Response::ATCommand::Accessor<C>::Get(rsp);
+        }
+
+        return result;
+    }
+};
+
+// co_await Await(net.BeginTransaction(addr)->Transmit(buff, n)), for chains
+// already pended. With RXBEE_THREADED only from the Service thread.
+inline TransactionAwaiter Await(Transaction* t)
+{
+    return TransactionAwaiter(t);
+}
+
+inline TransactionAwaiter operator co_await(Transaction& t)
+{
+    return TransactionAwaiter(&t);
+}
+
+// Minimal eagerly started, detached coroutine type for driving awaitables
+// from Service callbacks. Any coroutine return type can be used instead.
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object() noexcept { return Task(); }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_HAS_COROUTINES
+
+#endif // RXBEE_AWAITABLE_H
@@ -0,0 +1,91 @@
+
+#include "EndpointTable.h"
+
+#define RXBEE_ENDPOINT_EMPTY        (0xFFFFFFFFFFFFFFFFULL)     // Keys use 40 bits
+
+namespace RXBee
+{
+
+EndpointTable::EndpointTable() : count(0)
+{
+    for (uint16_t i = 0; i < RXBEE_ENDPOINT_TABLE_SIZE; ++i)
+    {
+        entries[i].key = RXBEE_ENDPOINT_EMPTY;
+        entries[i].handler = NULL;
+        entries[i].context = NULL;
+    }
+}
+
+uint64_t EndpointTable::Key(uint8_t endpoint, uint16_t cluster, uint16_t profile)
+{
+    return (static_cast<uint64_t>(endpoint) << 32) |
+           (static_cast<uint64_t>(cluster) << 16) |
+           profile;
+}
+
+uint16_t EndpointTable::Probe(uint64_t key) const
+{
+    return Table::Probe(entries, &Entry::key, key, RXBEE_ENDPOINT_EMPTY);
+}
+
+bool EndpointTable::Register(uint8_t endpoint, uint16_t cluster, uint16_t profile,
+                             EndpointTable::Handler handler, void* context)
+{
+    bool registered = false;
+    uint64_t key = Key(endpoint, cluster, profile);
+    uint16_t i = Probe(key);
+
+    if ((entries[i].key == key) || (count < Table::MAX_COUNT))
+    {
+        if (entries[i].key != key)
+        {
+            entries[i].key = key;
+            count++;
+        }
+        entries[i].handler = handler;
+        entries[i].context = context;
+        registered = true;
+    }
+
+    return registered;
+}
+
+bool EndpointTable::Unregister(uint8_t endpoint, uint16_t cluster, uint16_t profile)
+{
+    bool removed = false;
+    uint64_t key = Key(endpoint, cluster, profile);
+    uint16_t hole = Probe(key);
+
+    if (entries[hole].key == key)
+    {
+        hole = Table::Erase(entries, &Entry::key, hole, RXBEE_ENDPOINT_EMPTY);
+        entries[hole].handler = NULL;
+        entries[hole].context = NULL;
+        count--;
+        removed = true;
+    }
+
+    return removed;
+}
+
+bool EndpointTable::Dispatch(XBeeNetwork* source, const Response::ExplicitReceivePacket& packet,
+                             const std::vector<uint8_t>& data) const
+{
+    bool dispatched = false;
+    uint16_t i = Probe(Key(packet.destination_endpoint, packet.cluster_id, packet.profile_id));
+
+    if ((entries[i].key != RXBEE_ENDPOINT_EMPTY) && (entries[i].handler != NULL))
+    {
+        entries[i].handler(source, packet, data, entries[i].context);
+        dispatched = true;
+    }
+
+    return dispatched;
+}
+
+uint16_t EndpointTable::GetCount() const
+{
+    return count;
+}
+
+} // namespace RXBee
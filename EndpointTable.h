@@ -0,0 +1,64 @@
+#ifndef RXBEE_ENDPOINT_TABLE_H
+#define RXBEE_ENDPOINT_TABLE_H
+
+#include <stdint.h>
+
+#include "Types.h"
+#include "SpecificResponses.h"
+#include "OpenAddressing.h"
+
+#ifndef RXBEE_ENDPOINT_TABLE_SIZE
+    #define RXBEE_ENDPOINT_TABLE_SIZE   (16)    // Slots, power of two
+#endif
+
+namespace RXBee
+{
+
+class XBeeNetwork;
+
+// Routes explicit receive frames (0x91) to the service registered for
+// their (destination endpoint, cluster, profile). Open addressed, see
+// OpenAddressing, so a lookup is one hash and usually one compare.
+class EndpointTable
+{
+public:
+    typedef void (*Handler)(XBeeNetwork* source,
+                            const Response::ExplicitReceivePacket& packet,
+                            const std::vector<uint8_t>& data,
+                            void* context);
+
+    EndpointTable();
+
+    // Replaces an existing registration, false when the table is full
+    bool Register(uint8_t endpoint, uint16_t cluster, uint16_t profile,
+                  Handler handler, void* context);
+
+    bool Unregister(uint8_t endpoint, uint16_t cluster, uint16_t profile);
+
+    // Calls the registered handler, false when there is none
+    bool Dispatch(XBeeNetwork* source, const Response::ExplicitReceivePacket& packet,
+                  const std::vector<uint8_t>& data) const;
+
+    uint16_t GetCount() const;
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        Handler handler;
+        void* context;
+    };
+
+    typedef OpenAddressing<uint64_t, RXBEE_ENDPOINT_TABLE_SIZE> Table;
+
+    static uint64_t Key(uint8_t endpoint, uint16_t cluster, uint16_t profile);
+
+    uint16_t Probe(uint64_t key) const;
+
+    Entry entries[RXBEE_ENDPOINT_TABLE_SIZE];
+    uint16_t count;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_ENDPOINT_TABLE_H
@@ -0,0 +1,222 @@
+
+#include <string.h>
+
+#include "FleetOperation.h"
+#include "Network.h"
+
+namespace RXBee
+{
+
+FleetOperation::FleetOperation(XBeeNetwork* network)
+    : net(network), next_target(0), in_flight(0),
+      concurrency(RXBEE_FLEET_CONCURRENCY), running(false), started(0),
+      on_complete_handler(NULL), on_complete_context(NULL)
+{
+    command[0] = '\0';
+}
+
+FleetOperation::~FleetOperation()
+{
+
+}
+
+void FleetOperation::SetConcurrency(uint16_t limit)
+{
+    concurrency = (limit > 0) ? limit : 1;
+}
+
+void FleetOperation::OnComplete(FleetOperation::CompleteHandler handler, void* context)
+{
+    on_complete_handler = handler;
+    on_complete_context = context;
+}
+
+bool FleetOperation::Read(const std::vector<Address>& nodes, const char* cmd)
+{
+    param.clear();
+    return Start(nodes, cmd);
+}
+
+bool FleetOperation::Start(const std::vector<Address>& nodes, const char* cmd)
+{
+    bool success = !running && (net != NULL);
+
+    if (success)
+    {
+        strncpy(command, cmd, 2);
+        command[2] = '\0';
+
+        targets = nodes;
+        results.clear();
+        next_target = 0;
+        in_flight = 0;
+        started = net->GetUptime();
+        running = true;
+
+        Issue();
+
+        if (targets.empty())
+        {
+            Finish();
+        }
+    }
+
+    return success;
+}
+
+bool FleetOperation::ReadBroadcast(const char* cmd, int32_t window_ms)
+{
+    bool success = !running && (net != NULL);
+
+    if (success)
+    {
+        strncpy(command, cmd, 2);
+        command[2] = '\0';
+
+        targets.clear();
+        param.clear();
+        results.clear();
+        next_target = 0;
+        in_flight = 1;
+        started = net->GetUptime();
+        running = true;
+
+        Transaction* t = net->BeginBroadcastTransaction()->ReadParameter(command);
+        t->OnComplete(HandleBroadcastComplete, this);
+        t->Collect(window_ms, HandleResponse, this);
+        t->Pend();
+    }
+
+    return success;
+}
+
+bool FleetOperation::IsComplete() const
+{
+    return !running;
+}
+
+const FleetOperation::Results& FleetOperation::GetResults() const
+{
+    return results;
+}
+
+uint16_t FleetOperation::GetSuccessCount() const
+{
+    uint16_t count = 0;
+    for (Results::const_iterator it = results.begin(); it != results.end(); ++it)
+    {
+        if (it->second.error == Transaction::Error::NONE)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+void FleetOperation::Issue()
+{
+    while ((in_flight < concurrency) && (next_target < targets.size()))
+    {
+        Address addr = targets[next_target++];
+
+        Result& r = results[addr];
+        r.error = Transaction::Error::NONE;
+        r.status = Response::ATCommand::Status::INVALID_STATUS;
+        r.issued = net->GetUptime();
+        r.latency = 0;
+        r.data.clear();
+
+        Transaction* t = net->BeginTransaction(addr)->ReadParameter(command);
+        if (!param.empty())
+        {
+            t->GetFrame()->AddData(param);
+        }
+        t->OnComplete(HandleComplete, this);
+
+        in_flight++;
+        t->Pend();
+    }
+}
+
+void FleetOperation::Gather(Address addr, Transaction::Error error, Frame* frame)
+{
+    std::pair<Results::iterator, bool> entry = results.insert(std::make_pair(addr, Result()));
+    Result& r = entry.first->second;
+
+    if (entry.second)
+    {
+        // Broadcast responder, never issued on its own
+        r.issued = started;
+    }
+
+    r.error = error;
+    r.status = Response::ATCommand::Status::INVALID_STATUS;
+    r.latency = net->GetUptime() - r.issued;
+    r.data.clear();
+
+    if (frame != NULL)
+    {
+        Response::ApiFrame api_frame(frame);
+        Response::ATCommand::Response rsp(api_frame);
+        if (rsp.extracted)
+        {
+            r.status = rsp.status;
+            frame->GetData(rsp.data_offset, r.data);
+        }
+    }
+}
+
+void FleetOperation::Finish()
+{
+    running = false;
+
+    if (on_complete_handler != NULL)
+    {
+        on_complete_handler(this, on_complete_context);
+    }
+}
+
+void FleetOperation::HandleComplete(Transaction* transaction, void* context)
+{
+    FleetOperation* op = static_cast<FleetOperation*>(context);
+
+    if ((op != NULL) && (transaction != NULL))
+    {
+        // On timeout the frame is still the request, Gather ignores it
+        op->Gather(transaction->GetDestination(), transaction->GetError(),
+                   transaction->GetFrame());
+
+        op->in_flight--;
+        op->Issue();
+
+        if ((op->in_flight == 0) && (op->next_target >= op->targets.size()))
+        {
+            op->Finish();
+        }
+    }
+}
+
+void FleetOperation::HandleBroadcastComplete(Transaction*, void* context)
+{
+    FleetOperation* op = static_cast<FleetOperation*>(context);
+
+    if (op != NULL)
+    {
+        op->in_flight = 0;
+        op->Finish();
+    }
+}
+
+void FleetOperation::HandleResponse(Transaction*, Frame& frame, void* context)
+{
+    FleetOperation* op = static_cast<FleetOperation*>(context);
+    Response::ApiFrame api_frame(&frame);
+    Response::ATCommand::Response rsp(api_frame);
+
+    if ((op != NULL) && rsp.extracted && rsp.remote)
+    {
+        op->Gather(rsp.source_addr, Transaction::ToError(rsp.status), &frame);
+    }
+}
+
+} // namespace RXBee
@@ -0,0 +1,103 @@
+#ifndef RXBEE_FLEET_OPERATION_H
+#define RXBEE_FLEET_OPERATION_H
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "Types.h"
+#include "Transaction.h"
+#include "SpecificResponses.h"
+
+#ifndef RXBEE_FLEET_CONCURRENCY
+    #define RXBEE_FLEET_CONCURRENCY  (8)    // Remote commands in flight
+#endif
+
+namespace RXBee
+{
+
+class XBeeNetwork;
+
+// Runs one AT command on a set of nodes (scatter) and gathers the
+// responses by address. At most the concurrency limit of remote commands
+// are in flight, the next node is issued as each one completes.
+//
+//   FleetOperation op(&net);
+//   op.OnComplete(Done, NULL);
+//   op.Read(nodes, XBEE_CMD_NP);
+//   ... Service() until Done, then op.GetResults()
+class FleetOperation
+{
+public:
+    struct Result
+    {
+        Transaction::Error error;
+        Response::ATCommand::Status status;
+        uint32_t issued;                // Network uptime when issued
+        uint32_t latency;               // Milliseconds until the response
+        std::vector<uint8_t> data;      // Response parameter, if any
+    };
+
+    typedef std::map<Address, Result> Results;
+
+    typedef void (*CompleteHandler)(FleetOperation* operation, void* context);
+
+    FleetOperation(XBeeNetwork* network);
+    ~FleetOperation();
+
+    void SetConcurrency(uint16_t limit);
+
+    void OnComplete(CompleteHandler handler, void* context);
+
+    // Returns false while a previous operation is still running
+    bool Read(const std::vector<Address>& nodes, const char* cmd);
+
+    template<typename T>
+    bool Write(const std::vector<Address>& nodes, const char* cmd, const T value)
+    {
+        param.clear();
+        for (int16_t i = sizeof(T) - 1; i >= 0; --i)
+        {
+            param.push_back((value >> (8 * i)) & 0xFF);
+        }
+        return Start(nodes, cmd);
+    }
+
+    // Broadcasts cmd once and gathers every node that answers within
+    // window_ms. Nodes that do not answer are simply absent from the results.
+    bool ReadBroadcast(const char* cmd, int32_t window_ms);
+
+    bool IsComplete() const;
+
+    const Results& GetResults() const;
+
+    // Nodes answered with Error::NONE
+    uint16_t GetSuccessCount() const;
+
+private:
+    static void HandleComplete(Transaction* transaction, void* context);
+    static void HandleBroadcastComplete(Transaction* transaction, void* context);
+    static void HandleResponse(Transaction* transaction, Frame& frame, void* context);
+
+    bool Start(const std::vector<Address>& nodes, const char* cmd);
+    void Issue();
+    void Gather(Address addr, Transaction::Error error, Frame* frame);
+    void Finish();
+
+    XBeeNetwork* net;
+    std::vector<Address> targets;
+    std::vector<uint8_t> param;
+    char command[3];
+    uint16_t next_target;
+    uint16_t in_flight;
+    uint16_t concurrency;
+    bool running;
+    uint32_t started;
+    Results results;
+    CompleteHandler on_complete_handler;
+    void* on_complete_context;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_FLEET_OPERATION_H
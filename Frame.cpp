@@ -1,17 +1,18 @@
 #include <sstream>
 #include <vector>
+#include <string.h>
 
 #include "Frame.h"
+#include "FrameCodec.h"
 
 namespace RXBee
 {
 
-static bool ApiIdHasFid(const ApiID id);
-
 // Frame
 // Constructor
 Frame::Frame()
-    : mode(ApiMode::TRANSPARENT), has_fid(false)
+    : borrowed(NULL), borrowed_len(0), mode(ApiMode::TRANSPARENT), has_fid(false),
+      escaping(false), hunting(false), escaped(0), discarded(0), corrupted(0), resyncs(0)
 {
 }
 
@@ -22,23 +23,48 @@ Frame::~Frame()
 Frame::Frame(const Frame& other)
 {
     mode = other.mode;
-    data = other.data;
+    data.assign(other.Bytes(), other.Bytes() + other.Length());
+    borrowed = NULL;
+    borrowed_len = 0;
     has_fid = other.has_fid;
+    escaping = other.escaping;
+    hunting = other.hunting;
+    escaped = other.escaped;
+    discarded = other.discarded;
+    corrupted = other.corrupted;
+    resyncs = other.resyncs;
 }
 
 Frame& Frame::operator=(const Frame& l)
 {
     mode = l.mode;
-    data = l.data;
+    if (this != &l)
+    {
+        data.assign(l.Bytes(), l.Bytes() + l.Length());
+        borrowed = NULL;
+        borrowed_len = 0;
+    }
     has_fid = l.has_fid;
+    escaping = l.escaping;
+    hunting = l.hunting;
+    escaped = l.escaped;
+    discarded = l.discarded;
+    corrupted = l.corrupted;
+    resyncs = l.resyncs;
+    return *this;
 }
 
 void Frame::Initialize(const ApiID id, const ApiMode api_mode)
 {
     mode = api_mode;
     has_fid = ApiIdHasFid(id);
+    escaping = false;
+    hunting = false;
+    ResetCounts();
+    borrowed = NULL;
+    borrowed_len = 0;
     
-    if (mode != ApiMode::TRANSPARENT)
+    if (GetApiMode() != ApiMode::TRANSPARENT)
     {
         uint8_t initial_size = 1;
         if (has_fid)
@@ -64,6 +90,9 @@ void Frame::Initialize(const ApiMode api_mode)
 {
     mode = api_mode;
     has_fid = false;
+    escaping = false;
+    hunting = false;
+    ResetCounts();
     Clear();
 }
 
@@ -125,18 +154,20 @@ bool Frame::GetField(const uint16_t index, char* field, uint16_t& length,
               const  uint16_t max_length) const
 {
     bool success = false;
-    uint16_t max = GetSize() - index;
+    const uint8_t* bytes = Bytes();
+    uint16_t end = (GetApiMode() != ApiMode::TRANSPARENT) ? XBEE_FRAME_API_ID_INDEX + GetSize() : Length();
+    uint16_t max = (end > index) ? end - index : 0;
        
     if (max > max_length)
     {
         max = max_length;
     }
     
-    if (data.size() >= index + max)
+    if (Length() >= index + max)
     {
         for (length = 0; (length < max) ; ++length)
         {
-            field[length] = data[index + length];
+            field[length] = bytes[index + length];
             if (field[length] == '\0')
             {
                 break;
@@ -152,14 +183,15 @@ bool Frame::GetField(const uint16_t index, std::string& field, uint16_t& length)
 {
     std::stringstream ss;
     bool success = false;
+    const uint8_t* bytes = Bytes();
     uint16_t max = GetSize() - index;
     
-    if (data.size() >= index + max)
+    if (Length() >= index + max)
     {
         for (length = 0; length < max; ++length)
         {
-            ss << data[index + length];
-            if (data[index + length] == '\0')
+            ss << bytes[index + length];
+            if (bytes[index + length] == '\0')
             {
                 break;
             }
@@ -174,18 +206,20 @@ bool Frame::GetData(const uint16_t index, uint8_t* bytes, uint16_t& length,
              uint16_t max_length) const
 {
     bool success = false;
-    uint16_t max = GetSize() - index;
+    const uint8_t* frame_bytes = Bytes();
+    uint16_t end = (GetApiMode() != ApiMode::TRANSPARENT) ? XBEE_FRAME_API_ID_INDEX + GetSize() : Length();
+    uint16_t max = (end > index) ? end - index : 0;
        
     if (max > max_length)
     {
         max = max_length;
     }
     
-    if (data.size() >= index + max)
+    if (Length() >= index + max)
     {
         for (length = 0; (length < max) ; ++length)
         {
-            bytes[length] = data[index + length];
+            bytes[length] = frame_bytes[index + length];
         }
         success = true;
     }
@@ -196,18 +230,19 @@ bool Frame::GetData(const uint16_t index, uint8_t* bytes, uint16_t& length,
 bool Frame::GetData(const uint16_t index, std::vector<uint8_t>& bytes) const
 {
     bool success = false;
-    uint16_t end_index = data.size() - 1;
+    const uint8_t* frame_bytes = Bytes();
+    uint16_t end_index = Length() - 1;
     
-    if (mode != ApiMode::TRANSPARENT)
+    if (GetApiMode() != ApiMode::TRANSPARENT)
     {
         end_index = XBEE_FRAME_API_ID_INDEX + GetSize() - 1;
     }
     
-    if (data.size() > end_index)
+    if (Length() > end_index)
     {
         for (uint16_t i = index; i <= end_index; ++i )
         {
-            bytes.push_back(data[i]);
+            bytes.push_back(frame_bytes[i]);
         }
         success = true;
     }
@@ -219,15 +254,15 @@ uint16_t Frame::GetSize() const
 {
     uint16_t size = 0;
     
-    if ((data.size() > XBEE_FRAME_API_LENGTH_LSB) &&
-        (mode != ApiMode::TRANSPARENT))
+    if ((Length() > XBEE_FRAME_API_LENGTH_LSB) &&
+        (GetApiMode() != ApiMode::TRANSPARENT))
     {
-        size += (data[XBEE_FRAME_API_LENGTH_MSB] << 8);
-        size += data[XBEE_FRAME_API_LENGTH_LSB];
+        size += (Bytes()[XBEE_FRAME_API_LENGTH_MSB] << 8);
+        size += Bytes()[XBEE_FRAME_API_LENGTH_LSB];
     }
-    else if (mode == ApiMode::TRANSPARENT)
+    else if (GetApiMode() == ApiMode::TRANSPARENT)
     {
-        size = data.size();
+        size = Length();
     }
     else
     {
@@ -240,16 +275,18 @@ uint16_t Frame::GetSize() const
 void Frame::Clear()
 {
     data.clear();
+    borrowed = NULL;
+    borrowed_len = 0;
 }
 
 ApiID Frame::GetApiID() const
 {
     ApiID id = ApiID::UNKOWN;
     
-    if ((data.size() > XBEE_FRAME_API_ID_INDEX) &&
-        (mode != ApiMode::TRANSPARENT))
+    if ((Length() > XBEE_FRAME_API_ID_INDEX) &&
+        (GetApiMode() != ApiMode::TRANSPARENT))
     {
-        uint8_t n = data[XBEE_FRAME_API_ID_INDEX];
+        uint8_t n = Bytes()[XBEE_FRAME_API_ID_INDEX];
         
         if ((n == static_cast<uint8_t>(ApiID::AT_COMMAND)) ||
             (n == static_cast<uint8_t>(ApiID::AT_QUEUE_COMMAND)) || 
@@ -283,9 +320,9 @@ uint16_t Frame::GetFrameID() const
     uint16_t id = 0;
     if (has_fid)
     {
-        if (data.size() > XBEE_FRAME_API_FRAME_ID_INDEX)
+        if (Length() > XBEE_FRAME_API_FRAME_ID_INDEX)
         {
-            id = data[XBEE_FRAME_API_FRAME_ID_INDEX];
+            id = Bytes()[XBEE_FRAME_API_FRAME_ID_INDEX];
         }
     }
     return id;
@@ -311,15 +348,16 @@ uint8_t Frame::Checksum() const
 {
 	uint16_t total = 0;
     uint8_t checksum = XBEE_VALID_CHECKSUM;
+    const uint8_t* bytes = Bytes();
     
     // Only calculate checksum if the there is enough data
-    if (data.size() >= XBEE_FRAME_API_ID_INDEX + 1)
+    if (Length() >= XBEE_FRAME_API_ID_INDEX + 1)
     {
         
         // Checksum is the total of all bytes starting with the frame ID.
-        for (uint16_t i = XBEE_FRAME_API_ID_INDEX; i < data.size(); ++i)
+        for (uint16_t i = XBEE_FRAME_API_ID_INDEX; i < Length(); ++i)
         {
-            total += data[i];
+            total += bytes[i];
         }
     
         // Checksum is 0xFF minus the LSB of the total
@@ -338,17 +376,18 @@ bool Frame::Validate() const
 {
     bool valid = false;
     
-    if (mode != ApiMode::TRANSPARENT)
+    if (GetApiMode() != ApiMode::TRANSPARENT)
     {
         uint16_t total = 0;
+        const uint8_t* bytes = Bytes();
 
         // Only calculate checksum if the there is enough data
-        if (data.size() >= XBEE_FRAME_API_ID_INDEX + 1)
+        if (Length() >= XBEE_FRAME_API_ID_INDEX + 1)
         {
             // Checksum is the total of all bytes starting with the frame ID.
-            for (uint16_t i = XBEE_FRAME_API_ID_INDEX; i < data.size(); ++i)
+            for (uint16_t i = XBEE_FRAME_API_ID_INDEX; i < Length(); ++i)
             {
-                total += data[i];
+                total += bytes[i];
             }
 
             // Checksum is valid if the LSB of the total equals 0xFF
@@ -368,44 +407,22 @@ std::vector<uint8_t> Frame::Serialize() const
 {
     std::vector<uint8_t> serial_data;
     
-    uint8_t checksum = Checksum();
-    
-    for(uint16_t i = 0; i < data.size(); ++i)
+#if RXBEE_FIXED_API_MODE >= 0
+    FrameCodec<static_cast<ApiMode>(RXBEE_FIXED_API_MODE)>::Serialize(*this, serial_data);
+#else
+    switch (mode)
     {
-        // Apply escape character if needed
-        if ((mode == ApiMode::ESCAPED) &&
-            (i > 0) &&
-            ((data[i] == XBEE_PACKET_START) ||
-             (data[i] == XBEE_ESCAPE_BYTE) ||
-             (data[i] == XBEE_XON) ||
-             (data[i] == XBEE_XOFF)))
-        {
-            serial_data.push_back(XBEE_ESCAPE_BYTE);
-            serial_data.push_back(data[i] ^ XBEE_ESCAPE_MASK);
-        }
-        else
-        {
-            serial_data.push_back(data[i]);
-        }
-    }
-    
-    if (mode != ApiMode::TRANSPARENT)
-    {
-        // Escape checksum if needed
-        if ((mode == ApiMode::ESCAPED) &&
-            ((checksum == XBEE_PACKET_START) ||
-             (checksum == XBEE_ESCAPE_BYTE) ||
-             (checksum == XBEE_XON) ||
-             (checksum == XBEE_XOFF)))
-        {
-            serial_data.push_back(XBEE_ESCAPE_BYTE);
-            serial_data.push_back(checksum ^ XBEE_ESCAPE_MASK);
-        }
-        else
-        {
-            serial_data.push_back(checksum);
-        }
+        case ApiMode::ESCAPED:
+            FrameCodec<ApiMode::ESCAPED>::Serialize(*this, serial_data);
+            break;
+        case ApiMode::UNESCAPED:
+            FrameCodec<ApiMode::UNESCAPED>::Serialize(*this, serial_data);
+            break;
+        default:
+            FrameCodec<ApiMode::TRANSPARENT>::Serialize(*this, serial_data);
+            break;
     }
+#endif
     
     return serial_data;
 }
@@ -414,108 +431,78 @@ bool Frame::Deserialize(const std::vector<uint8_t>& serial_data, uint16_t& index
 {
     bool complete = false;  // Set to true when entire frame is deserialized
     
-    Deserialize(&serial_data[0], serial_data.size(), index);
-    
-    has_fid = ApiIdHasFid(GetApiID());
+    if (!serial_data.empty())
+    {
+        complete = Deserialize(&serial_data[0], serial_data.size(), index);
+    }
     
     return complete;
 }
 
 
     
-bool Frame::Deserialize(const uint8_t* buff, const uint16_t buff_size, uint16_t& index)
+bool Frame::Deserialize(const uint8_t* buff, const uint16_t buff_size, uint16_t& index,
+                        bool in_place)
 {
     bool complete = false;  // Set to true when entire frame is deserialized
-    bool started = false;
-        
-    if (data.size() == 0)   // No characters have been received
-    {
-        while (index < buff_size)   // Loop until a start character
-        { 
-            if (buff[index] == XBEE_PACKET_START)
-            { 
-                // Got start of packet character
-                data.push_back(buff[index]);
-                break;
-            }
-            ++index;
-        }
-    }
-    
-    if (data.size() == 1)   // Got start of packet character
-    {
-        while (index < buff_size)   // Loop until a non start character
-        { 
-            if (buff[index] == XBEE_PACKET_START)
-            { 
-                ++index;
-            }
-            else
-            {
-                break;
-            }
-        }
-    }
-        
-    
     
-    for(; index < buff_size; ++index)
+#if RXBEE_FIXED_API_MODE >= 0
+    complete = FrameCodec<static_cast<ApiMode>(RXBEE_FIXED_API_MODE)>::Deserialize(*this, buff,
+                                                                                  buff_size, index,
+                                                                                  in_place);
+#else
+    switch (mode)
     {
-        if ((mode == ApiMode::ESCAPED) &&
-            (data.size() > 0) &&
-            (buff[index]) == XBEE_ESCAPE_BYTE)
-        {
-            if ((buff[index]) == XBEE_PACKET_START)
-            {
-                // Frame error
-                Initialize(ApiMode::ESCAPED);
-                data.push_back(buff[index]);
-            }
-            // Escape character is last in buffer, leave it until 
-            // more data is available
-            if (index == buff_size - 1)
-            {
-                break;
-            }
-            else
-            {
-                index++;
-                data.push_back(buff[index] ^ XBEE_ESCAPE_MASK);
-            }
-        }
-        else
-        {
-            data.push_back(buff[index]);
-        }
-        
-        
-        if (mode != ApiMode::TRANSPARENT)
-        {
-            // Entire frame is deserialized when the length of data is
-            // the length specified in the packet plus the number
-            // of framing bytes (start, length, checksum).
-            if ((data.size() > XBEE_FRAME_API_LENGTH_LSB) &&
-                (data.size() == (GetSize() + XBEE_FRAMING_SIZE)))
-            {
-                complete = true;
-                has_fid = ApiIdHasFid(GetApiID());
-                break;
-            }
-        }
-    }
-    
-    if (mode == ApiMode::TRANSPARENT)
-    {
-        complete = true;
+        case ApiMode::ESCAPED:
+            complete = FrameCodec<ApiMode::ESCAPED>::Deserialize(*this, buff, buff_size, index,
+                                                                 in_place);
+            break;
+        case ApiMode::UNESCAPED:
+            complete = FrameCodec<ApiMode::UNESCAPED>::Deserialize(*this, buff, buff_size, index,
+                                                                   in_place);
+            break;
+        default:
+            complete = FrameCodec<ApiMode::TRANSPARENT>::Deserialize(*this, buff, buff_size, index,
+                                                                     in_place);
+            break;
     }
+#endif
     
     return complete;
 }
 
 
+uint16_t Frame::GetEscapedCount() const
+{
+    return escaped;
+}
+
+uint16_t Frame::GetDiscardedCount() const
+{
+    return discarded;
+}
+
+uint16_t Frame::GetCorruptedCount() const
+{
+    return corrupted;
+}
+
+uint16_t Frame::GetResyncCount() const
+{
+    return resyncs;
+}
+
+void Frame::ResetCounts()
+{
+    escaped = 0;
+    discarded = 0;
+    corrupted = 0;
+    resyncs = 0;
+}
+
 void Frame::AddSize(uint16_t size)
 {
-    if (mode != ApiMode::TRANSPARENT)
+    if (GetApiMode() != ApiMode::TRANSPARENT)
     {
         // Add size to frame size bytes
         size += (data[XBEE_FRAME_API_LENGTH_MSB] << 8);
@@ -527,7 +514,7 @@ void Frame::AddSize(uint16_t size)
 }
 
 
-bool ApiIdHasFid(const ApiID id)
+bool Frame::ApiIdHasFid(const ApiID id)
 {
     bool has_fid = false;
     if ((id == ApiID::AT_COMMAND) ||
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "Types.h"
+#include "RXBee_Config.h"
 
 #define XBEE_PACKET_START   (0x7e)
 #define XBEE_FRAME_MAXSIZE  (0x1ff)
@@ -26,6 +27,8 @@
 
 namespace RXBee
 {
+
+template<ApiMode M> class FrameCodec;
     
 class Frame
 {
@@ -70,6 +73,22 @@ public:
 
     Frame* AddData(const std::vector<uint8_t>& bytes);
     
+    // Overwrites a field already added at index
+    template<typename T>
+    bool SetField(const uint16_t index, const T field)
+    {
+        bool success = false;
+        if (data.size() >= index + sizeof(T))
+        {
+            for (uint16_t i = 0; i < sizeof(T); ++i)
+            {
+                data[index + i] = (field >> (8 * (sizeof(T) - 1 - i))) & 0xFF;
+            }
+            success = true;
+        }
+        return success;
+    }
+    
     template<typename T, typename ...Ts>
     bool GetFields(uint16_t index, T& field, Ts&... fields) const
     {
@@ -88,13 +107,14 @@ public:
     bool GetField(const uint16_t index, T& field) const
     {
         bool success = false;
-        if (data.size() > index + sizeof(T))
+        if (Length() > index + sizeof(T))
         {
+            const uint8_t* bytes = Bytes();
             field = 0;
             for (uint16_t i = 0; i < sizeof(T); ++i)
             {
                 field = field << 8;
-                field += (data[index + i]);
+                field += (bytes[index + i]);
             }
             success = true;
         }
@@ -112,6 +132,17 @@ public:
     
     uint16_t GetSize() const;
     
+    // Mode the frame is encoded in, constant when built with
+    // RXBEE_FIXED_API_MODE
+    ApiMode GetApiMode() const
+    {
+#if RXBEE_FIXED_API_MODE >= 0
+        return static_cast<ApiMode>(RXBEE_FIXED_API_MODE);
+#else
+        return mode;
+#endif
+    }
+    
     void Clear();
 
     ApiID GetApiID() const;
@@ -130,13 +161,47 @@ public:
     
     bool Deserialize(const std::vector<uint8_t>& serial_data, uint16_t& index);
     
-    bool Deserialize(const uint8_t* buff, const uint16_t buff_size, uint16_t& index);
+    // With in_place an unescaped frame found whole in buff is referenced
+    // rather than copied, buff must then stay unchanged until the frame is
+    // cleared or initialized. Copies of the frame own their bytes.
+    bool Deserialize(const uint8_t* buff, const uint16_t buff_size, uint16_t& index,
+                     bool in_place = false);
+    
+    // Escape bytes removed and bytes skipped looking for a start byte by
+    // Deserialize since Initialize or ResetCounts
+    uint16_t GetEscapedCount() const;
+    
+    uint16_t GetDiscardedCount() const;
+    
+    // Frames dropped by Deserialize for an impossible length or cut short
+    // by a start byte, and runs of bytes skipped to find a start byte
+    uint16_t GetCorruptedCount() const;
+    
+    uint16_t GetResyncCount() const;
+    
+    void ResetCounts();
     
 private:
+    template<ApiMode M> friend class FrameCodec;
+    
+    static bool ApiIdHasFid(const ApiID id);
+    
+    // The frame bytes, in data or referenced by Deserialize in place
+    const uint8_t* Bytes() const { return (borrowed != NULL) ? borrowed : data.data(); }
+    uint16_t Length() const { return (borrowed != NULL) ? borrowed_len : data.size(); }
+    
     void AddSize(uint16_t size);
     std::vector<uint8_t> data;
+    const uint8_t* borrowed;
+    uint16_t borrowed_len;
     ApiMode mode;
     bool has_fid;
+    bool escaping;      // Escape byte received, its data byte not yet
+    bool hunting;       // Skipping bytes to find a start byte
+    uint16_t escaped;
+    uint16_t discarded;
+    uint16_t corrupted;
+    uint16_t resyncs;
 };
 
 } // namespace XBee
@@ -0,0 +1,233 @@
+#ifndef RXBEE_FRAME_CODEC_H
+#define RXBEE_FRAME_CODEC_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "Frame.h"
+
+namespace RXBee
+{
+
+// Serial encoding of frames for one API mode. The mode is a template
+// argument, so the per byte escape and framing branches are resolved at
+// compile time. Frame::Serialize and Frame::Deserialize pick the
+// instantiation once per call, or always the same one when the library is
+// built with RXBEE_FIXED_API_MODE.
+template<ApiMode M>
+class FrameCodec
+{
+public:
+    static bool IsEscaped(uint8_t byte)
+    {
+        return (byte == XBEE_PACKET_START) || (byte == XBEE_ESCAPE_BYTE) ||
+               (byte == XBEE_XON) || (byte == XBEE_XOFF);
+    }
+
+    // Frame size including start, length and checksum, once the length
+    // bytes have been received
+    static uint16_t GetTotalSize(const std::vector<uint8_t>& data)
+    {
+        return ((data[XBEE_FRAME_API_LENGTH_MSB] << 8) | data[XBEE_FRAME_API_LENGTH_LSB]) +
+               XBEE_FRAMING_SIZE;
+    }
+
+    // Appends the frame as sent on the serial line to serial_data
+    static void Serialize(const Frame& frame, std::vector<uint8_t>& serial_data)
+    {
+        const uint8_t* data = frame.Bytes();
+        uint16_t length = frame.Length();
+
+        if (M == ApiMode::ESCAPED)
+        {
+            uint8_t checksum = frame.Checksum();
+
+            serial_data.reserve(serial_data.size() + length + 8);
+            for (uint16_t i = 0; i < length; ++i)
+            {
+                // Everything but the start byte is escaped
+                if ((i > 0) && IsEscaped(data[i]))
+                {
+                    serial_data.push_back(XBEE_ESCAPE_BYTE);
+                    serial_data.push_back(data[i] ^ XBEE_ESCAPE_MASK);
+                }
+                else
+                {
+                    serial_data.push_back(data[i]);
+                }
+            }
+
+            if (IsEscaped(checksum))
+            {
+                serial_data.push_back(XBEE_ESCAPE_BYTE);
+                serial_data.push_back(checksum ^ XBEE_ESCAPE_MASK);
+            }
+            else
+            {
+                serial_data.push_back(checksum);
+            }
+        }
+        else
+        {
+            serial_data.insert(serial_data.end(), data, data + length);
+            if (M == ApiMode::UNESCAPED)
+            {
+                serial_data.push_back(frame.Checksum());
+            }
+        }
+    }
+
+    // Continues the frame with the bytes from index up to buff_size, see
+    // Frame::Deserialize
+    static bool Deserialize(Frame& frame, const uint8_t* buff, const uint16_t buff_size,
+                            uint16_t& index, bool in_place)
+    {
+        bool complete = false;
+        std::vector<uint8_t>& data = frame.data;
+
+        if (M == ApiMode::TRANSPARENT)
+        {
+            data.insert(data.end(), buff + index, buff + buff_size);
+            index = buff_size;
+            complete = true;
+        }
+
+        while ((index < buff_size) && !complete)
+        {
+            if (data.size() == 0)   // Hunting for a start character
+            {
+                const uint8_t* start = static_cast<const uint8_t*>(
+                    memchr(&buff[index], XBEE_PACKET_START, buff_size - index));
+                uint16_t skip = (start != NULL) ? (start - &buff[index]) : (buff_size - index);
+
+                if ((skip > 0) && !frame.hunting)
+                {
+                    frame.hunting = true;
+                    ++frame.resyncs;
+                }
+                frame.discarded += skip;
+                index += skip;
+
+                if (start != NULL)
+                {
+                    // Got start of packet character
+                    uint16_t total = 0;
+                    if ((M == ApiMode::UNESCAPED) && in_place &&
+                        ((buff_size - index) > XBEE_FRAME_API_LENGTH_LSB))
+                    {
+                        total = ((buff[index + XBEE_FRAME_API_LENGTH_MSB] << 8) |
+                                 buff[index + XBEE_FRAME_API_LENGTH_LSB]) + XBEE_FRAMING_SIZE;
+                    }
+
+                    if ((total > XBEE_FRAMING_SIZE) &&
+                        (total <= XBEE_FRAME_MAXSIZE + XBEE_FRAMING_SIZE) &&
+                        (total <= (buff_size - index)))
+                    {
+                        // The whole frame is in buff, reference it there
+                        frame.borrowed = &buff[index];
+                        frame.borrowed_len = total;
+                        index += total;
+                        complete = true;
+                    }
+                    else
+                    {
+                        data.push_back(XBEE_PACKET_START);
+                        ++index;
+                    }
+                    frame.hunting = false;
+                }
+            }
+            else if ((data.size() == 1) && (buff[index] == XBEE_PACKET_START))
+            {
+                // Repeated start character
+                ++index;
+                ++frame.discarded;
+            }
+            else if ((M == ApiMode::UNESCAPED) && (data.size() >= XBEE_FRAME_API_ID_INDEX))
+            {
+                // Nothing is escaped, so once the length is known the rest
+                // of the frame is copied as it arrives
+                uint16_t total = GetTotalSize(data);
+                uint16_t take = total - data.size();
+                if (take > (buff_size - index))
+                {
+                    take = buff_size - index;
+                }
+
+                data.insert(data.end(), &buff[index], &buff[index] + take);
+                index += take;
+
+                if (data.size() == total)
+                {
+                    complete = true;
+                }
+            }
+            else
+            {
+                uint8_t byte = buff[index++];
+
+                if ((M == ApiMode::ESCAPED) && (byte == XBEE_PACKET_START))
+                {
+                    // Start characters are always escaped inside a frame,
+                    // so this one starts the next frame and the current
+                    // one was cut short
+                    data.clear();
+                    data.push_back(byte);
+                    frame.escaping = false;
+                    ++frame.corrupted;
+                }
+                else if ((M == ApiMode::ESCAPED) && frame.escaping)
+                {
+                    data.push_back(byte ^ XBEE_ESCAPE_MASK);
+                    frame.escaping = false;
+                }
+                else if ((M == ApiMode::ESCAPED) && (byte == XBEE_ESCAPE_BYTE))
+                {
+                    // The escaped byte may only arrive with the next call
+                    frame.escaping = true;
+                    ++frame.escaped;
+                }
+                else
+                {
+                    data.push_back(byte);
+                }
+
+                if (data.size() == XBEE_FRAME_API_ID_INDEX)
+                {
+                    uint16_t total = GetTotalSize(data);
+                    if ((total == XBEE_FRAMING_SIZE) ||
+                        (total > XBEE_FRAME_MAXSIZE + XBEE_FRAMING_SIZE))
+                    {
+                        // Impossible length, hunt for the next start character
+                        data.clear();
+                        ++frame.corrupted;
+                    }
+                    else
+                    {
+                        data.reserve(total);
+                    }
+                }
+                else if ((data.size() > XBEE_FRAME_API_ID_INDEX) &&
+                         (data.size() == GetTotalSize(data)))
+                {
+                    // Entire frame is deserialized when the length of data
+                    // is the length specified in the packet plus the number
+                    // of framing bytes (start, length, checksum).
+                    complete = true;
+                }
+            }
+        }
+
+        if (complete && (M != ApiMode::TRANSPARENT))
+        {
+            frame.has_fid = Frame::ApiIdHasFid(frame.GetApiID());
+        }
+
+        return complete;
+    }
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_FRAME_CODEC_H
@@ -0,0 +1,351 @@
+
+#include <stdio.h>
+
+#include "Histogram.h"
+
+#define RXBEE_HISTOGRAM_SUB_COUNT   (1 << RXBEE_HISTOGRAM_SUB_BITS)
+#define RXBEE_HISTOGRAM_MAX_VALUE   ((1UL << RXBEE_HISTOGRAM_RANGE_BITS) - 1)
+
+namespace RXBee
+{
+
+static_assert(RXBEE_HISTOGRAM_RANGE_BITS <= 31, "RXBEE_HISTOGRAM_RANGE_BITS must be at most 31");
+
+Histogram::Histogram()
+{
+    Clear();
+}
+
+void Histogram::Clear()
+{
+    for (uint16_t i = 0; i < RXBEE_HISTOGRAM_BUCKETS; ++i)
+    {
+        buckets[i] = 0;
+    }
+    count = 0;
+    min = 0;
+    max = 0;
+    sum = 0;
+}
+
+uint16_t Histogram::GetIndex(uint32_t value)
+{
+    uint16_t index = 0;
+
+    if (value > RXBEE_HISTOGRAM_MAX_VALUE)
+    {
+        value = RXBEE_HISTOGRAM_MAX_VALUE;
+    }
+
+    if (value < RXBEE_HISTOGRAM_SUB_COUNT)
+    {
+        index = value;
+    }
+    else
+    {
+        // Power of two k >= SUB_BITS holds buckets (k - SUB_BITS + 1) * SUB
+        // onwards, each 2^(k - SUB_BITS) wide
+        uint8_t k = 31 - __builtin_clz(value);
+        uint8_t shift = k - RXBEE_HISTOGRAM_SUB_BITS;
+        index = ((shift + 1) << RXBEE_HISTOGRAM_SUB_BITS) +
+                ((value >> shift) - RXBEE_HISTOGRAM_SUB_COUNT);
+    }
+
+    return index;
+}
+
+uint32_t Histogram::GetUpperBound(uint16_t index)
+{
+    uint32_t bound = index + 1;
+
+    if (index >= RXBEE_HISTOGRAM_SUB_COUNT)
+    {
+        uint8_t shift = (index >> RXBEE_HISTOGRAM_SUB_BITS) - 1;
+        uint32_t sub = index & (RXBEE_HISTOGRAM_SUB_COUNT - 1);
+        bound = (RXBEE_HISTOGRAM_SUB_COUNT + sub + 1) << shift;
+    }
+
+    return bound;
+}
+
+void Histogram::Record(uint32_t value)
+{
+    buckets[GetIndex(value)]++;
+
+    if ((count == 0) || (value < min))
+    {
+        min = value;
+    }
+    if (value > max)
+    {
+        max = value;
+    }
+    count++;
+    sum += value;
+}
+
+void Histogram::Merge(const Histogram& other)
+{
+    if (other.count > 0)
+    {
+        for (uint16_t i = 0; i < RXBEE_HISTOGRAM_BUCKETS; ++i)
+        {
+            buckets[i] += other.buckets[i];
+        }
+
+        if ((count == 0) || (other.min < min))
+        {
+            min = other.min;
+        }
+        if (other.max > max)
+        {
+            max = other.max;
+        }
+        count += other.count;
+        sum += other.sum;
+    }
+}
+
+uint32_t Histogram::GetCount() const
+{
+    return count;
+}
+
+uint32_t Histogram::GetMin() const
+{
+    return min;
+}
+
+uint32_t Histogram::GetMax() const
+{
+    return max;
+}
+
+uint64_t Histogram::GetSum() const
+{
+    return sum;
+}
+
+uint32_t Histogram::GetBucketCount(uint16_t index) const
+{
+    return (index < RXBEE_HISTOGRAM_BUCKETS) ? buckets[index] : 0;
+}
+
+uint32_t Histogram::GetQuantile(double quantile) const
+{
+    uint32_t value = 0;
+    uint32_t rank = static_cast<uint32_t>(quantile * count + 0.5);
+    uint32_t seen = 0;
+
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+
+    for (uint16_t i = 0; (i < RXBEE_HISTOGRAM_BUCKETS) && (count > 0); ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            value = GetUpperBound(i) - 1;
+            break;
+        }
+    }
+
+    // The bucket bound can overshoot what was actually recorded
+    if (value > max)
+    {
+        value = max;
+    }
+    if (value < min)
+    {
+        value = min;
+    }
+
+    return value;
+}
+
+void Histogram::ExportText(const char* name, const char* labels, std::string& out) const
+{
+    char line[160];
+    const char* separator = (labels[0] != '\0') ? "," : "";
+    uint32_t cumulative = 0;
+
+    for (uint16_t i = 0; i < RXBEE_HISTOGRAM_BUCKETS; ++i)
+    {
+        if (buckets[i] > 0)
+        {
+            cumulative += buckets[i];
+            snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"%lu\"} %lu\n", name, labels, separator,
+                     static_cast<unsigned long>(GetUpperBound(i) - 1),
+                     static_cast<unsigned long>(cumulative));
+            out += line;
+        }
+    }
+
+    snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, separator,
+             static_cast<unsigned long>(count));
+    out += line;
+    snprintf(line, sizeof(line), "%s_sum{%s} %llu\n", name, labels,
+             static_cast<unsigned long long>(sum));
+    out += line;
+    snprintf(line, sizeof(line), "%s_count{%s} %lu\n", name, labels,
+             static_cast<unsigned long>(count));
+    out += line;
+}
+
+static void AppendBinary(std::vector<uint8_t>& out, uint64_t value, uint8_t bytes)
+{
+    for (int8_t i = bytes - 1; i >= 0; --i)
+    {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void Histogram::ExportBinary(std::vector<uint8_t>& out) const
+{
+    uint16_t used = 0;
+    for (uint16_t i = 0; i < RXBEE_HISTOGRAM_BUCKETS; ++i)
+    {
+        used += (buckets[i] > 0);
+    }
+
+    out.push_back(RXBEE_HISTOGRAM_BINARY_VERSION);
+    AppendBinary(out, count, 4);
+    AppendBinary(out, min, 4);
+    AppendBinary(out, max, 4);
+    AppendBinary(out, sum, 8);
+    AppendBinary(out, used, 2);
+
+    for (uint16_t i = 0; i < RXBEE_HISTOGRAM_BUCKETS; ++i)
+    {
+        if (buckets[i] > 0)
+        {
+            AppendBinary(out, i, 2);
+            AppendBinary(out, buckets[i], 4);
+        }
+    }
+}
+
+LatencyStats::LatencyStats()
+{
+
+}
+
+DestinationClass LatencyStats::Classify(Address addr)
+{
+    DestinationClass dest = DestinationClass::UNICAST;
+
+    if (addr == RXBEE_LOCAL_ADDRESS)
+    {
+        dest = DestinationClass::LOCAL;
+    }
+    else if (addr == XBEE_BROADCAST_ADDRESS)
+    {
+        dest = DestinationClass::BROADCAST;
+    }
+
+    return dest;
+}
+
+Histogram* LatencyStats::Get(DestinationClass dest, ApiID api, LatencyStage stage)
+{
+    Histogram* h = const_cast<Histogram*>(Find(dest, api, stage));
+
+    if (h == NULL)
+    {
+        entries.push_back(Entry());
+        entries.back().dest = dest;
+        entries.back().api = api;
+        entries.back().stage = stage;
+        h = &entries.back().histogram;
+    }
+
+    return h;
+}
+
+const Histogram* LatencyStats::Find(DestinationClass dest, ApiID api, LatencyStage stage) const
+{
+    const Histogram* h = NULL;
+
+    for (uint16_t i = 0; (i < entries.size()) && (h == NULL); ++i)
+    {
+        if ((entries[i].dest == dest) && (entries[i].api == api) && (entries[i].stage == stage))
+        {
+            h = &entries[i].histogram;
+        }
+    }
+
+    return h;
+}
+
+void LatencyStats::Record(DestinationClass dest, ApiID api, LatencyStage stage, uint32_t us)
+{
+    Get(dest, api, stage)->Record(us);
+}
+
+void LatencyStats::RecordService(uint32_t us)
+{
+    service.Record(us);
+}
+
+const Histogram& LatencyStats::GetServiceHistogram() const
+{
+    return service;
+}
+
+void LatencyStats::Merge(const LatencyStats& other)
+{
+    for (uint16_t i = 0; i < other.entries.size(); ++i)
+    {
+        const Entry& e = other.entries[i];
+        Get(e.dest, e.api, e.stage)->Merge(e.histogram);
+    }
+    service.Merge(other.service);
+}
+
+void LatencyStats::Clear()
+{
+    entries.clear();
+    service.Clear();
+}
+
+void LatencyStats::ExportText(std::string& out) const
+{
+    static const char* dest_names[] = { "local", "unicast", "broadcast" };
+    static const char* stage_names[] = { "build", "queue", "response", "total" };
+    char labels[64];
+
+    out += "# TYPE rxbee_transaction_latency_microseconds histogram\n";
+    for (uint16_t i = 0; i < entries.size(); ++i)
+    {
+        const Entry& e = entries[i];
+        snprintf(labels, sizeof(labels), "dest=\"%s\",api=\"0x%02X\",stage=\"%s\"",
+                 dest_names[static_cast<uint8_t>(e.dest)], static_cast<unsigned>(e.api),
+                 stage_names[static_cast<uint8_t>(e.stage)]);
+        e.histogram.ExportText("rxbee_transaction_latency_microseconds", labels, out);
+    }
+
+    out += "# TYPE rxbee_service_duration_microseconds histogram\n";
+    service.ExportText("rxbee_service_duration_microseconds", "", out);
+}
+
+void LatencyStats::ExportBinary(std::vector<uint8_t>& out) const
+{
+    AppendBinary(out, entries.size() + 1, 2);
+
+    for (uint16_t i = 0; i < entries.size(); ++i)
+    {
+        out.push_back(static_cast<uint8_t>(entries[i].dest));
+        out.push_back(static_cast<uint8_t>(entries[i].api));
+        out.push_back(static_cast<uint8_t>(entries[i].stage));
+        entries[i].histogram.ExportBinary(out);
+    }
+
+    out.push_back(0xFF);
+    out.push_back(0xFF);
+    out.push_back(0xFF);
+    service.ExportBinary(out);
+}
+
+} // namespace RXBee
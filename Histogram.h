@@ -0,0 +1,140 @@
+#ifndef RXBEE_HISTOGRAM_H
+#define RXBEE_HISTOGRAM_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+#ifndef RXBEE_HISTOGRAM_SUB_BITS
+    #define RXBEE_HISTOGRAM_SUB_BITS    (3)     // 2^n buckets per power of two, 12.5% precision
+#endif
+
+#ifndef RXBEE_HISTOGRAM_RANGE_BITS
+    #define RXBEE_HISTOGRAM_RANGE_BITS  (27)    // Largest value recorded, 134 s in microseconds
+#endif
+
+#define RXBEE_HISTOGRAM_BUCKETS     ((RXBEE_HISTOGRAM_RANGE_BITS - RXBEE_HISTOGRAM_SUB_BITS + 1) << \
+                                     RXBEE_HISTOGRAM_SUB_BITS)
+#define RXBEE_HISTOGRAM_BINARY_VERSION  (1)
+
+namespace RXBee
+{
+
+// Fixed memory log-linear histogram in the style of HdrHistogram: values
+// below 2^RXBEE_HISTOGRAM_SUB_BITS get a bucket each, every power of two
+// above is split into 2^RXBEE_HISTOGRAM_SUB_BITS equal buckets. Larger
+// values land in the last bucket. Histograms with the same configuration
+// can be merged, e.g. across several networks.
+class Histogram
+{
+public:
+    Histogram();
+
+    void Record(uint32_t value);
+
+    void Merge(const Histogram& other);
+
+    void Clear();
+
+    uint32_t GetCount() const;
+
+    uint32_t GetMin() const;
+
+    uint32_t GetMax() const;
+
+    uint64_t GetSum() const;
+
+    // Highest value of the bucket holding the quantile, e.g. 0.99
+    uint32_t GetQuantile(double quantile) const;
+
+    uint32_t GetBucketCount(uint16_t index) const;
+
+    static uint16_t GetIndex(uint32_t value);
+
+    // Smallest value of the next bucket
+    static uint32_t GetUpperBound(uint16_t index);
+
+    // Prometheus histogram series (_bucket, _sum, _count) of one label
+    // set, labels are "" or e.g. "stage=\"queue\"". Empty buckets are left out.
+    void ExportText(const char* name, const char* labels, std::string& out) const;
+
+    // Version byte, count, min, max (32 bit), sum (64 bit), the number of
+    // non-empty buckets (16 bit) and an index (16 bit) and count (32 bit)
+    // for each of them, all big endian
+    void ExportBinary(std::vector<uint8_t>& out) const;
+
+private:
+    uint32_t buckets[RXBEE_HISTOGRAM_BUCKETS];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+};
+
+enum class DestinationClass : uint8_t
+{
+    LOCAL,
+    UNICAST,
+    BROADCAST
+};
+
+// Transaction timestamps are taken at INITIALIZED, PENDING, SENT and
+// COMPLETE. Each stage spans two of them.
+enum class LatencyStage : uint8_t
+{
+    BUILD,          // Begin to Pend, time spent by the application
+    QUEUE,          // Pend to sent, waiting for the radio or earlier links
+    RESPONSE,       // Sent to complete, radio and air time
+    TOTAL           // Begin to complete
+};
+
+// Transaction latency by destination class, API ID and stage, plus the
+// duration of XBeeNetwork::Service calls. A histogram is allocated the
+// first time its key is recorded. Times are in microseconds.
+class LatencyStats
+{
+public:
+    LatencyStats();
+
+    void Record(DestinationClass dest, ApiID api, LatencyStage stage, uint32_t us);
+
+    void RecordService(uint32_t us);
+
+    // NULL when nothing was recorded for the key
+    const Histogram* Find(DestinationClass dest, ApiID api, LatencyStage stage) const;
+
+    const Histogram& GetServiceHistogram() const;
+
+    void Merge(const LatencyStats& other);
+
+    void Clear();
+
+    void ExportText(std::string& out) const;
+
+    // Number of histograms (16 bit), then for each the destination class,
+    // API ID and stage bytes followed by Histogram::ExportBinary. The
+    // Service histogram comes last with all three bytes 0xFF.
+    void ExportBinary(std::vector<uint8_t>& out) const;
+
+    static DestinationClass Classify(Address addr);
+
+private:
+    struct Entry
+    {
+        DestinationClass dest;
+        ApiID api;
+        LatencyStage stage;
+        Histogram histogram;
+    };
+
+    Histogram* Get(DestinationClass dest, ApiID api, LatencyStage stage);
+
+    std::vector<Entry> entries;
+    Histogram service;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_HISTOGRAM_H
@@ -0,0 +1,155 @@
+
+#include "IOSampling.h"
+
+#define RXBEE_IO_HISTORY_EMPTY      (RXBEE_LOCAL_ADDRESS)   // Never a remote node
+
+namespace RXBee
+{
+
+IOSampleBatch::IOSampleBatch() : count(0)
+{
+
+}
+
+void IOSampleBatch::Clear()
+{
+    count = 0;
+}
+
+bool IOSampleBatch::IsFull() const
+{
+    return (count >= RXBEE_IO_BATCH_SIZE);
+}
+
+bool IOSampleBatch::Add(const Response::ExplicitIOSample& sample, uint32_t now)
+{
+    bool added = false;
+
+    if (!IsFull())
+    {
+        source[count] = sample.source_addr;
+        time[count] = now;
+        digital_mask[count] = sample.digital_channel_mask;
+        digital[count] = sample.digital_samples;
+        analog_mask[count] = sample.analog_channel_mask;
+        for (uint8_t c = 0; c < XBEE_IO_ANALOG_CHANNELS; ++c)
+        {
+            analog[c][count] = sample.analog_samples[c];
+        }
+        count++;
+        added = true;
+    }
+
+    return added;
+}
+
+IOSampleHistory::IOSampleHistory()
+{
+    Clear();
+}
+
+void IOSampleHistory::Clear()
+{
+    for (uint16_t i = 0; i < RXBEE_IO_HISTORY_NODES; ++i)
+    {
+        nodes[i].address = RXBEE_IO_HISTORY_EMPTY;
+        nodes[i].head = 0;
+        nodes[i].count = 0;
+    }
+    node_count = 0;
+}
+
+uint16_t IOSampleHistory::Probe(Address addr) const
+{
+    return Table::Probe(nodes, &Node::address, addr, RXBEE_IO_HISTORY_EMPTY);
+}
+
+uint16_t IOSampleHistory::Record(const IOSampleBatch& batch)
+{
+    uint16_t recorded = 0;
+
+    for (uint16_t s = 0; s < batch.count; ++s)
+    {
+        uint16_t i = Probe(batch.source[s]);
+
+        if ((nodes[i].address == RXBEE_IO_HISTORY_EMPTY) &&
+            (batch.source[s] != RXBEE_IO_HISTORY_EMPTY) &&
+            (node_count < Table::MAX_COUNT))
+        {
+            nodes[i].address = batch.source[s];
+            node_count++;
+        }
+
+        if (nodes[i].address == batch.source[s])
+        {
+            Node& node = nodes[i];
+            Sample& sample = node.samples[node.head];
+            sample.time = batch.time[s];
+            sample.digital = batch.digital[s];
+            sample.analog_mask = batch.analog_mask[s];
+            for (uint8_t c = 0; c < XBEE_IO_ANALOG_CHANNELS; ++c)
+            {
+                sample.analog[c] = batch.analog[c][s];
+            }
+
+            node.head = (node.head + 1) % RXBEE_IO_HISTORY_DEPTH;
+            if (node.count < RXBEE_IO_HISTORY_DEPTH)
+            {
+                node.count++;
+            }
+            recorded++;
+        }
+    }
+
+    return recorded;
+}
+
+bool IOSampleHistory::Get(Address node, uint16_t age, IOSampleHistory::Sample& sample) const
+{
+    bool found = false;
+    const Node& n = nodes[Probe(node)];
+
+    if ((n.address != RXBEE_IO_HISTORY_EMPTY) && (age < n.count))
+    {
+        sample = n.samples[(n.head + RXBEE_IO_HISTORY_DEPTH - 1 - age) % RXBEE_IO_HISTORY_DEPTH];
+        found = true;
+    }
+
+    return found;
+}
+
+uint16_t IOSampleHistory::GetCount(Address node) const
+{
+    const Node& n = nodes[Probe(node)];
+    return (n.address != RXBEE_IO_HISTORY_EMPTY) ? n.count : 0;
+}
+
+bool IOSampleHistory::Average(Address node, uint8_t channel, uint16_t n, uint16_t& mean) const
+{
+    uint32_t sum = 0;
+    uint16_t used = 0;
+    const Node& history = nodes[Probe(node)];
+
+    if ((history.address != RXBEE_IO_HISTORY_EMPTY) && (channel < XBEE_IO_ANALOG_CHANNELS))
+    {
+        for (uint16_t age = 0; (used < n) && (age < history.count); ++age)
+        {
+            const Sample& sample = history.samples[(history.head + RXBEE_IO_HISTORY_DEPTH - 1 - age) %
+                                                   RXBEE_IO_HISTORY_DEPTH];
+            if (sample.analog_mask & (1 << channel))
+            {
+                sum += sample.analog[channel];
+                used++;
+            }
+        }
+    }
+
+    if (used > 0)
+    {
+        mean = static_cast<uint16_t>(sum / used);
+    }
+
+    return (used > 0);
+}
+
+} // namespace RXBee
@@ -0,0 +1,103 @@
+#ifndef RXBEE_IO_SAMPLING_H
+#define RXBEE_IO_SAMPLING_H
+
+#include <stdint.h>
+
+#include "Types.h"
+#include "SpecificResponses.h"
+#include "OpenAddressing.h"
+
+#ifndef RXBEE_IO_BATCH_SIZE
+    #define RXBEE_IO_BATCH_SIZE         (16)    // Samples per handler call at most
+#endif
+
+#ifndef RXBEE_IO_HISTORY_NODES
+    #define RXBEE_IO_HISTORY_NODES      (16)    // Slots, power of two
+#endif
+
+#ifndef RXBEE_IO_HISTORY_DEPTH
+    #define RXBEE_IO_HISTORY_DEPTH      (16)    // Samples kept per node
+#endif
+
+namespace RXBee
+{
+
+// IO samples (0x92) received during one Service call, one column per
+// field so a handler can walk a single channel of every node without
+// touching the rest. Analog values are the raw 10 bit ADC counts.
+struct IOSampleBatch
+{
+    IOSampleBatch();
+
+    void Clear();
+
+    // False when the batch is full
+    bool Add(const Response::ExplicitIOSample& sample, uint32_t now);
+
+    bool IsFull() const;
+
+    uint16_t count;
+    Address source[RXBEE_IO_BATCH_SIZE];
+    uint32_t time[RXBEE_IO_BATCH_SIZE];             // Network uptime in milliseconds
+    uint16_t digital_mask[RXBEE_IO_BATCH_SIZE];
+    uint16_t digital[RXBEE_IO_BATCH_SIZE];
+    uint8_t analog_mask[RXBEE_IO_BATCH_SIZE];
+    uint16_t analog[XBEE_IO_ANALOG_CHANNELS][RXBEE_IO_BATCH_SIZE];
+};
+
+// The latest RXBEE_IO_HISTORY_DEPTH samples of up to 3/4 of
+// RXBEE_IO_HISTORY_NODES nodes in fixed rings, for averaging or
+// downsampling without allocating per sample. Nodes are keyed in an open
+// addressed table, see OpenAddressing. Samples of nodes beyond the limit
+// are not recorded until Clear().
+//
+//   void HandleSamples(XBeeNetwork* net, const IOSampleBatch& batch, void* context)
+//   {
+//       static_cast<IOSampleHistory*>(context)->Record(batch);
+//   }
+class IOSampleHistory
+{
+public:
+    struct Sample
+    {
+        uint32_t time;
+        uint16_t digital;
+        uint8_t analog_mask;
+        uint16_t analog[XBEE_IO_ANALOG_CHANNELS];
+    };
+
+    IOSampleHistory();
+
+    // Returns the number of samples recorded
+    uint16_t Record(const IOSampleBatch& batch);
+
+    // Age 0 is the latest sample, false when there are fewer samples
+    bool Get(Address node, uint16_t age, Sample& sample) const;
+
+    uint16_t GetCount(Address node) const;
+
+    // Mean of the latest n samples carrying the channel, false when none do
+    bool Average(Address node, uint8_t channel, uint16_t n, uint16_t& mean) const;
+
+    void Clear();
+
+private:
+    struct Node
+    {
+        Address address;
+        uint16_t head;          // Next slot written
+        uint16_t count;
+        Sample samples[RXBEE_IO_HISTORY_DEPTH];
+    };
+
+    typedef OpenAddressing<Address, RXBEE_IO_HISTORY_NODES> Table;
+
+    uint16_t Probe(Address addr) const;
+
+    Node nodes[RXBEE_IO_HISTORY_NODES];
+    uint16_t node_count;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_IO_SAMPLING_H
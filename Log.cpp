@@ -0,0 +1,101 @@
+
+#include <stdio.h>
+
+#include "Log.h"
+
+#define RXBEE_LOG_MASK  (RXBEE_LOG_SIZE - 1)
+
+namespace RXBee
+{
+
+static_assert((RXBEE_LOG_SIZE & RXBEE_LOG_MASK) == 0, "RXBEE_LOG_SIZE must be a power of two");
+static_assert(RXBEE_LOG_SIZE <= 32768, "RXBEE_LOG_SIZE must be at most 32768");
+
+struct LogMessage
+{
+    uint8_t level;
+    const char* format;
+};
+
+static const LogMessage messages[static_cast<uint8_t>(LogID::COUNT)] =
+{
+    { RXBEE_LOG_LEVEL_WARNING,  "RXBee: RX overrun, buffer reset" },
+    { RXBEE_LOG_LEVEL_ERROR,    "RXBee: Transactions cleared!" },
+    { RXBEE_LOG_LEVEL_INFO,     "RXBee: Transaction Timeout, Retrying : %lu" },
+    { RXBEE_LOG_LEVEL_ERROR,    "RXBee: ERROR Transaction Timeout : %lu" },
+    { RXBEE_LOG_LEVEL_DEBUG,    "RXBee: Transaction sent to %lx%08lx, id => %lu" },
+    { RXBEE_LOG_LEVEL_DEBUG,    "RXBee: Transaction created[%lu]" },
+    { RXBEE_LOG_LEVEL_DEBUG,    "Transaction status = %lu, id => %lu" },
+    { RXBEE_LOG_LEVEL_DEBUG,    "Transaction completed, id => %lu" }
+};
+
+LogRing::LogRing()
+{
+
+}
+
+void LogRing::Write(uint32_t time, LogID id, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+    uint16_t t = tail.Load();
+
+    if (static_cast<uint16_t>(t - head.Acquire()) < RXBEE_LOG_SIZE)
+    {
+        LogRecord& r = records[t & RXBEE_LOG_MASK];
+        r.time = time;
+        r.id = id;
+        r.args[0] = a0;
+        r.args[1] = a1;
+        r.args[2] = a2;
+        tail.Release(t + 1);
+    }
+    else
+    {
+        dropped.Increment();
+    }
+}
+
+bool LogRing::Read(LogRecord& record)
+{
+    bool result = false;
+    uint16_t h = head.Load();
+
+    if (tail.Acquire() != h)
+    {
+        record = records[h & RXBEE_LOG_MASK];
+        head.Release(h + 1);
+        result = true;
+    }
+
+    return result;
+}
+
+uint32_t LogRing::GetDropped() const
+{
+    return dropped.Get();
+}
+
+uint8_t LogRing::GetLevel(LogID id)
+{
+    return (id < LogID::COUNT) ? messages[static_cast<uint8_t>(id)].level : RXBEE_LOG_LEVEL_DEBUG;
+}
+
+const char* LogRing::GetFormat(LogID id)
+{
+    return (id < LogID::COUNT) ? messages[static_cast<uint8_t>(id)].format : "RXBee: Unknown log %lu";
+}
+
+int LogRing::Format(const LogRecord& record, char* buffer, size_t size)
+{
+    unsigned long a0 = record.args[0];
+    unsigned long a1 = record.args[1];
+    unsigned long a2 = record.args[2];
+
+    if (record.id >= LogID::COUNT)
+    {
+        a0 = static_cast<uint8_t>(record.id);
+    }
+
+    return snprintf(buffer, size, GetFormat(record.id), a0, a1, a2);
+}
+
+} // namespace RXBee
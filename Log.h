@@ -0,0 +1,110 @@
+#ifndef RXBEE_LOG_H
+#define RXBEE_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "RXBee_Config.h"
+#include "SpscRing.h"
+#include "Metrics.h"
+
+#ifndef RXBEE_LOG_SIZE
+    #define RXBEE_LOG_SIZE          (64)    // Records, power of two
+#endif
+
+#define RXBEE_LOG_ARGS              (3)
+
+#define RXBEE_LOG_LEVEL_ERROR       (1)
+#define RXBEE_LOG_LEVEL_WARNING     (2)
+#define RXBEE_LOG_LEVEL_INFO        (3)
+#define RXBEE_LOG_LEVEL_DEBUG       (4)
+
+// Calls below RXBEE_LOG_LEVEL compile to nothing, arguments included.
+// target is the XBeeNetwork, e.g. RXBEE_LOG_INFO(this, LogID::..., i)
+#if RXBEE_LOG_LEVEL >= RXBEE_LOG_LEVEL_ERROR
+    #define RXBEE_LOG_ERROR(target, ...)    (target)->Log(__VA_ARGS__)
+#else
+    #define RXBEE_LOG_ERROR(target, ...)
+#endif
+
+#if RXBEE_LOG_LEVEL >= RXBEE_LOG_LEVEL_WARNING
+    #define RXBEE_LOG_WARNING(target, ...)  (target)->Log(__VA_ARGS__)
+#else
+    #define RXBEE_LOG_WARNING(target, ...)
+#endif
+
+#if RXBEE_LOG_LEVEL >= RXBEE_LOG_LEVEL_INFO
+    #define RXBEE_LOG_INFO(target, ...)     (target)->Log(__VA_ARGS__)
+#else
+    #define RXBEE_LOG_INFO(target, ...)
+#endif
+
+#if RXBEE_LOG_LEVEL >= RXBEE_LOG_LEVEL_DEBUG
+    #define RXBEE_LOG_DEBUG(target, ...)    (target)->Log(__VA_ARGS__)
+#else
+    #define RXBEE_LOG_DEBUG(target, ...)
+#endif
+
+namespace RXBee
+{
+
+// Static message, its level and format are looked up when the record is
+// formatted. Values are stable so recorded logs can be decoded offline.
+enum class LogID : uint8_t
+{
+    RX_OVERRUN = 0,
+    TRANSACTIONS_CLEARED = 1,
+    TRANSACTION_RETRY = 2,          // Pending index
+    TRANSACTION_TIMEOUT = 3,        // Pending index
+    TRANSACTION_SENT = 4,           // Destination high and low word, frame ID
+    TRANSACTION_CREATED = 5,        // Pending index
+    TRANSACTION_STATUS = 6,         // Delivery status, frame ID
+    TRANSACTION_COMPLETED = 7,      // Frame ID
+    COUNT
+};
+
+struct LogRecord
+{
+    uint32_t time;                  // Service uptime in milliseconds
+    LogID id;
+    uint32_t args[RXBEE_LOG_ARGS];
+};
+
+// Binary log of one XBeeNetwork. Writing copies the message ID and its raw
+// arguments into a fixed ring, formatting happens when the records are
+// read, on any thread, or offline. Records written while the ring is full
+// are dropped and counted.
+//
+// Write belongs to the Service thread, Read to one other thread.
+class LogRing
+{
+public:
+    LogRing();
+
+    void Write(uint32_t time, LogID id, uint32_t a0, uint32_t a1, uint32_t a2);
+
+    // Oldest record, false when empty
+    bool Read(LogRecord& record);
+
+    uint32_t GetDropped() const;
+
+    static uint8_t GetLevel(LogID id);
+
+    // printf format of the message, arguments as unsigned long
+    static const char* GetFormat(LogID id);
+
+    // Formats a record into buffer like snprintf
+    static int Format(const LogRecord& record, char* buffer, size_t size);
+
+private:
+    LogRecord records[RXBEE_LOG_SIZE];
+
+    // Free running, masked on access
+    RXBEE_CACHE_ALIGNED RingIndex head;
+    RXBEE_CACHE_ALIGNED RingIndex tail;
+    Counter dropped;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_LOG_H
@@ -0,0 +1,249 @@
+
+#include "MeshTopology.h"
+
+namespace RXBee
+{
+
+MeshTopology::MeshTopology()
+{
+    edges.reserve(RXBEE_TOPOLOGY_EDGES);
+}
+
+void MeshTopology::Record(const Response::RouteInformation& info, uint32_t now)
+{
+    TopologyEdge* edge = NULL;
+    uint8_t hop = 0;
+
+    for (uint16_t i = 0; i < edges.size(); ++i)
+    {
+        if ((edges[i].from == info.responder_addr) && (edges[i].to == info.receiver_addr))
+        {
+            edge = &edges[i];
+        }
+        else if ((edges[i].to == info.responder_addr) && (edges[i].origin == info.source_addr) &&
+                 (edges[i].hop > 0))
+        {
+            // Hops are reported in order, the previous one ends here
+            hop = edges[i].hop + 1;
+        }
+    }
+
+    if (info.responder_addr == info.source_addr)
+    {
+        hop = 1;
+    }
+
+    if (edge == NULL)
+    {
+        if (edges.size() < RXBEE_TOPOLOGY_EDGES)
+        {
+            edges.push_back(TopologyEdge());
+            edge = &edges.back();
+        }
+        else
+        {
+            edge = &edges[0];
+            for (uint16_t i = 1; i < edges.size(); ++i)
+            {
+                if (static_cast<int32_t>(edges[i].last_seen - edge->last_seen) < 0)
+                {
+                    edge = &edges[i];
+                }
+            }
+        }
+
+        edge->from = info.responder_addr;
+        edge->to = info.receiver_addr;
+        edge->traces = 0;
+        edge->nacks = 0;
+    }
+
+    edge->origin = info.source_addr;
+    edge->hop = hop;
+    edge->ack_timeouts = info.ack_timeout_count;
+    edge->tx_blocked = info.tx_blocked_count;
+    edge->last_seen = now;
+
+    if (info.trace)
+    {
+        edge->traces++;
+    }
+    else
+    {
+        edge->nacks++;
+    }
+}
+
+uint16_t MeshTopology::Expire(uint32_t now, uint32_t max_age)
+{
+    uint16_t removed = 0;
+
+    for (uint16_t i = 0; (max_age > 0) && (i < edges.size());)
+    {
+        if ((now - edges[i].last_seen) > max_age)
+        {
+            edges[i] = edges.back();
+            edges.pop_back();
+            removed++;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    return removed;
+}
+
+void MeshTopology::Remove(Address node)
+{
+    for (uint16_t i = 0; i < edges.size();)
+    {
+        if ((edges[i].from == node) || (edges[i].to == node))
+        {
+            edges[i] = edges.back();
+            edges.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void MeshTopology::Clear()
+{
+    edges.clear();
+}
+
+const TopologyEdge* MeshTopology::Find(Address from, Address to) const
+{
+    const TopologyEdge* edge = NULL;
+
+    for (uint16_t i = 0; (i < edges.size()) && (edge == NULL); ++i)
+    {
+        if ((edges[i].from == from) && (edges[i].to == to))
+        {
+            edge = &edges[i];
+        }
+    }
+
+    return edge;
+}
+
+uint16_t MeshTopology::GetNeighbours(Address node, std::vector<Address>& neighbours) const
+{
+    uint16_t added = 0;
+    uint16_t first = neighbours.size();
+
+    for (uint16_t i = 0; i < edges.size(); ++i)
+    {
+        Address other = node;
+        if (edges[i].from == node)
+        {
+            other = edges[i].to;
+        }
+        else if (edges[i].to == node)
+        {
+            other = edges[i].from;
+        }
+
+        bool known = (other == node);
+        for (uint16_t n = first; (n < neighbours.size()) && !known; ++n)
+        {
+            known = (neighbours[n] == other);
+        }
+
+        if (!known)
+        {
+            neighbours.push_back(other);
+            added++;
+        }
+    }
+
+    return added;
+}
+
+bool MeshTopology::FindPath(Address from, Address to, std::vector<Address>& path) const
+{
+    // Breadth first, parent[i] is the index in visited that reached visited[i]
+    std::vector<Address> visited;
+    std::vector<uint16_t> parent;
+    bool found = (from == to);
+
+    visited.push_back(from);
+    parent.push_back(0);
+
+    for (uint16_t v = 0; (v < visited.size()) && !found; ++v)
+    {
+        for (uint16_t i = 0; (i < edges.size()) && !found; ++i)
+        {
+            Address next = visited[v];
+            if (edges[i].from == visited[v])
+            {
+                next = edges[i].to;
+            }
+            else if (edges[i].to == visited[v])
+            {
+                next = edges[i].from;
+            }
+
+            bool seen = false;
+            for (uint16_t s = 0; (s < visited.size()) && !seen; ++s)
+            {
+                seen = (visited[s] == next);
+            }
+
+            if (!seen)
+            {
+                visited.push_back(next);
+                parent.push_back(v);
+                found = (next == to);
+            }
+        }
+    }
+
+    if (found)
+    {
+        uint16_t count = 1;
+        for (uint16_t v = visited.size() - 1; v != 0; v = parent[v])
+        {
+            count++;
+        }
+
+        path.assign(count, from);
+        for (uint16_t v = visited.size() - 1; v != 0; v = parent[v])
+        {
+            path[--count] = visited[v];
+        }
+    }
+
+    return found;
+}
+
+uint32_t MeshTopology::GetRelayCount(Address node) const
+{
+    uint32_t count = 0;
+
+    for (uint16_t i = 0; i < edges.size(); ++i)
+    {
+        if ((edges[i].from == node) && (edges[i].origin != node))
+        {
+            count += edges[i].traces + edges[i].nacks;
+        }
+    }
+
+    return count;
+}
+
+uint16_t MeshTopology::GetCount() const
+{
+    return edges.size();
+}
+
+const TopologyEdge& MeshTopology::GetEdge(uint16_t index) const
+{
+    return edges[index];
+}
+
+} // namespace RXBee
@@ -0,0 +1,77 @@
+#ifndef RXBEE_MESH_TOPOLOGY_H
+#define RXBEE_MESH_TOPOLOGY_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "Types.h"
+#include "SpecificResponses.h"
+
+#ifndef RXBEE_TOPOLOGY_EDGES
+    #define RXBEE_TOPOLOGY_EDGES        (64)        // Links kept, least recently seen replaced
+#endif
+
+#ifndef RXBEE_TOPOLOGY_MAX_AGE
+    #define RXBEE_TOPOLOGY_MAX_AGE      (900000)    // Milliseconds unseen before removal, 0 never
+#endif
+
+namespace RXBee
+{
+
+// One radio link of a route, as reported by the node that sent over it
+struct TopologyEdge
+{
+    Address from;               // Responder, forwarded the packet
+    Address to;                 // Receiver
+    Address origin;             // Source of the last route reported over the link
+    uint8_t hop;                // Position on that route, 1 leaves the source, 0 unknown
+    uint16_t traces;            // Trace route reports
+    uint16_t nacks;             // Reports of a missing network ACK past this link
+    uint8_t ack_timeouts;       // MAC ACK timeouts on the last report
+    uint8_t tx_blocked;         // Transmissions blocked by reception on the last report
+    uint32_t last_seen;         // Network uptime in milliseconds
+};
+
+// Mesh links learned from route information frames (0x8D). Those are only
+// sent for transmissions with XBEE_TX_OPTION_TRACE_ROUTE, or with
+// XBEE_TX_OPTION_NACK when a hop fails, one frame per hop. Paths and
+// neighbours treat links as bidirectional. Belongs to the Service thread.
+class MeshTopology
+{
+public:
+    MeshTopology();
+
+    void Record(const Response::RouteInformation& info, uint32_t now);
+
+    // Removes links not seen for max_age milliseconds, returns the count
+    uint16_t Expire(uint32_t now, uint32_t max_age);
+
+    // Removes every link of the node
+    void Remove(Address node);
+
+    void Clear();
+
+    const TopologyEdge* Find(Address from, Address to) const;
+
+    // Appends the nodes linked with node, returns how many were added
+    uint16_t GetNeighbours(Address node, std::vector<Address>& neighbours) const;
+
+    // Fewest hops from one node to another, both included. False when no
+    // known links connect them.
+    bool FindPath(Address from, Address to, std::vector<Address>& path) const;
+
+    // Reports of routes the node forwarded for other sources, a busy or
+    // congested relay shows many, along with ACK timeouts and NACKs
+    uint32_t GetRelayCount(Address node) const;
+
+    uint16_t GetCount() const;
+
+    const TopologyEdge& GetEdge(uint16_t index) const;
+
+private:
+    std::vector<TopologyEdge> edges;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_MESH_TOPOLOGY_H
@@ -0,0 +1,201 @@
+
+#include "MessageCoalescer.h"
+#include "Network.h"
+#include "Frame.h"
+
+namespace RXBee
+{
+
+MessageCoalescer::MessageCoalescer(XBeeNetwork* network) : net(network), delay(0)
+{
+
+}
+
+void MessageCoalescer::SetDelay(uint32_t delay_ms)
+{
+    delay = delay_ms;
+
+    if (delay == 0)
+    {
+        FlushAll();
+    }
+}
+
+uint32_t MessageCoalescer::GetDelay() const
+{
+    return delay;
+}
+
+uint16_t MessageCoalescer::CountEscapes(const uint8_t* data, uint16_t n)
+{
+    uint16_t escapes = 0;
+    for (uint16_t i = 0; i < n; ++i)
+    {
+        if ((data[i] == XBEE_PACKET_START) ||
+            (data[i] == XBEE_ESCAPE_BYTE) ||
+            (data[i] == XBEE_XON) ||
+            (data[i] == XBEE_XOFF))
+        {
+            ++escapes;
+        }
+    }
+    return escapes;
+}
+
+uint16_t MessageCoalescer::GetCapacity(uint16_t escapes) const
+{
+    // Same budget Transaction::Transmit uses before it fragments
+    uint16_t capacity = net->GetMaxPacketPayloadBytes();
+    uint16_t reserved = 0;
+
+    if (net->GetApiMode() == ApiMode::ESCAPED)
+    {
+        reserved = 3 + escapes;
+    }
+
+    return (capacity > reserved) ? (capacity - reserved) : 0;
+}
+
+void MessageCoalescer::Queue(Address dest, const uint8_t* data, uint16_t n, uint32_t now)
+{
+    uint8_t len = static_cast<uint8_t>(n);
+    uint16_t escapes = CountEscapes(data, n) + CountEscapes(&len, 1);
+    uint16_t b = 0;
+
+    for (; b < batches.size(); ++b)
+    {
+        if (batches[b].dest == dest)
+        {
+            break;
+        }
+    }
+
+    if ((b < batches.size()) &&
+        (1 + batches[b].data.size() + 1 + n > GetCapacity(batches[b].escapes + escapes)))
+    {
+        // Full, the message starts the next batch
+        Send(b);
+        b = batches.size();
+    }
+
+    if ((delay == 0) ||
+        (n > RXBEE_ENVELOPE_MAX_MESSAGE) ||
+        (2 + n > GetCapacity(escapes)))
+    {
+        if (b < batches.size())
+        {
+            // Keep the order of messages to the destination
+            Send(b);
+        }
+
+        Transaction* t = net->BeginTransaction(dest);
+        if (t != NULL)
+        {
+            t->Transmit(data, n);
+        }
+    }
+    else
+    {
+        if (b >= batches.size())
+        {
+            if (batches.size() >= RXBEE_COALESCE_DESTINATIONS)
+            {
+                uint16_t oldest = 0;
+                for (uint16_t i = 1; i < batches.size(); ++i)
+                {
+                    if (static_cast<int32_t>(batches[i].opened - batches[oldest].opened) < 0)
+                    {
+                        oldest = i;
+                    }
+                }
+                Send(oldest);
+            }
+
+            Batch batch;
+            batch.dest = dest;
+            batch.opened = now;
+            batch.escapes = 0;
+            batch.data.reserve(net->GetMaxPacketPayloadBytes());
+            batches.push_back(batch);
+            b = batches.size() - 1;
+        }
+
+        Batch& batch = batches[b];
+        batch.data.push_back(len);
+        batch.data.insert(batch.data.end(), data, data + n);
+        batch.escapes += escapes;
+
+        if (1 + batch.data.size() + 2 > GetCapacity(batch.escapes))
+        {
+            // No room left for even a one byte message
+            Send(b);
+        }
+    }
+}
+
+void MessageCoalescer::Flush(Address dest)
+{
+    for (uint16_t b = 0; b < batches.size(); ++b)
+    {
+        if (batches[b].dest == dest)
+        {
+            Send(b);
+            break;
+        }
+    }
+}
+
+void MessageCoalescer::FlushAll()
+{
+    while (!batches.empty())
+    {
+        Send(0);
+    }
+}
+
+void MessageCoalescer::Service(uint32_t now)
+{
+    for (uint16_t b = 0; b < batches.size();)
+    {
+        if (now - batches[b].opened >= delay)
+        {
+            Send(b);
+        }
+        else
+        {
+            ++b;
+        }
+    }
+}
+
+int32_t MessageCoalescer::GetNextTimeout(uint32_t now) const
+{
+    int32_t timeout = -1;
+
+    for (uint16_t b = 0; b < batches.size(); ++b)
+    {
+        uint32_t waited = now - batches[b].opened;
+        int32_t remaining = (waited >= delay) ? 0 : static_cast<int32_t>(delay - waited);
+
+        if ((timeout < 0) || (remaining < timeout))
+        {
+            timeout = remaining;
+        }
+    }
+
+    return timeout;
+}
+
+void MessageCoalescer::Send(uint16_t b)
+{
+    Transaction* t = net->BeginTransaction(batches[b].dest);
+    if (t != NULL)
+    {
+        t->TransmitEnvelope(RXBEE_ENVELOPE_COALESCED, &batches[b].data[0],
+                            batches[b].data.size(), true);
+    }
+
+    batches.erase(batches.begin() + b);
+}
+
+} // namespace RXBee
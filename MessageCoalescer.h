@@ -0,0 +1,71 @@
+#ifndef RXBEE_MESSAGE_COALESCER_H
+#define RXBEE_MESSAGE_COALESCER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "Types.h"
+#include "PayloadCodec.h"
+
+#ifndef RXBEE_COALESCE_DESTINATIONS
+    #define RXBEE_COALESCE_DESTINATIONS (8)     // Open batches, oldest flushed first
+#endif
+
+namespace RXBee
+{
+
+class XBeeNetwork;
+
+// Packs small messages to the same destination into one RF packet:
+//
+//   [0xA1] [len] [message] [len] [message] ...
+//
+// A batch is sent when the next message would not fit in
+// GetMaxPacketPayloadBytes() or when its oldest message has waited for the
+// delay. Messages too large for a batch are sent on their own, unwrapped.
+// The receiver splits enveloped packets back into the original messages,
+// see PayloadCodec.
+class MessageCoalescer
+{
+public:
+    MessageCoalescer(XBeeNetwork* network);
+
+    // 0 disables coalescing, messages are then sent immediately
+    void SetDelay(uint32_t delay_ms);
+
+    uint32_t GetDelay() const;
+
+    void Queue(Address dest, const uint8_t* data, uint16_t n, uint32_t now);
+
+    void Flush(Address dest);
+
+    void FlushAll();
+
+    // Called from XBeeNetwork::Service, sends batches past their delay
+    void Service(uint32_t now);
+
+    // Milliseconds until the oldest batch is due, -1 when none are open
+    int32_t GetNextTimeout(uint32_t now) const;
+
+private:
+    struct Batch
+    {
+        Address dest;
+        uint32_t opened;            // Network uptime of the first message
+        uint16_t escapes;           // Bytes the escaped API mode will double
+        std::vector<uint8_t> data;  // Envelope body, without the header
+    };
+
+    static uint16_t CountEscapes(const uint8_t* data, uint16_t n);
+
+    uint16_t GetCapacity(uint16_t escapes) const;
+    void Send(uint16_t b);
+
+    XBeeNetwork* net;
+    uint32_t delay;
+    std::vector<Batch> batches;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_MESSAGE_COALESCER_H
@@ -0,0 +1,170 @@
+
+#include <stdio.h>
+
+#include "Metrics.h"
+
+namespace RXBee
+{
+
+static const ApiID slot_ids[RXBEE_METRICS_API_SLOTS] =
+{
+    ApiID::AT_COMMAND,
+    ApiID::AT_QUEUE_COMMAND,
+    ApiID::TRANSMIT_REQUEST,
+    ApiID::EXPLICIT_ADDRESSING_COMMAND,
+    ApiID::REMOTE_AT_COMMAND,
+    ApiID::AT_COMMAND_RESPONSE,
+    ApiID::MODEM_STATUS,
+    ApiID::TRANSMIT_STATUS,
+    ApiID::ROUTE_INFO_PACKET,
+    ApiID::AGGREGATE_ADDRESSING_UPDATE,
+    ApiID::RECEIVE_PACKET,
+    ApiID::EXPLICIT_RX_INDICATOR,
+    ApiID::IO_DATA_SAMPLE_RX_INDICATOR,
+    ApiID::NODE_ID_INDICATOR,
+    ApiID::REMOTE_AT_COMMAND_RESPONSE,
+    ApiID::UNKOWN                       // Everything else
+};
+
+Metrics::Metrics()
+{
+
+}
+
+uint8_t Metrics::GetSlot(ApiID id)
+{
+    uint8_t slot = 0;
+    while ((slot < RXBEE_METRICS_API_SLOTS - 1) && (slot_ids[slot] != id))
+    {
+        slot++;
+    }
+    return slot;
+}
+
+ApiID Metrics::GetSlotApiID(uint8_t slot)
+{
+    return (slot < RXBEE_METRICS_API_SLOTS) ? slot_ids[slot] : ApiID::UNKOWN;
+}
+
+void Metrics::GetSnapshot(MetricsSnapshot& snapshot) const
+{
+    snapshot.rx_bytes = rx_bytes.Get();
+    snapshot.tx_bytes = tx_bytes.Get();
+    snapshot.rx_escapes = rx_escapes.Get();
+    snapshot.tx_escapes = tx_escapes.Get();
+    snapshot.checksum_failures = checksum_failures.Get();
+    snapshot.discarded_bytes = discarded_bytes.Get();
+    snapshot.corrupt_frames = corrupt_frames.Get();
+    snapshot.resyncs = resyncs.Get();
+    snapshot.rx_overruns = rx_overruns.Get();
+    snapshot.rx_high_water = rx_high_water.Get();
+    snapshot.transactions_created = transactions_created.Get();
+    snapshot.transactions_completed = transactions_completed.Get();
+    snapshot.transactions_timed_out = transactions_timed_out.Get();
+    snapshot.transactions_retried = transactions_retried.Get();
+    snapshot.transactions_overflowed = transactions_overflowed.Get();
+
+    for (uint8_t i = 0; i < RXBEE_METRICS_API_SLOTS; ++i)
+    {
+        snapshot.rx_frames[i] = rx_frames[i].Get();
+        snapshot.tx_frames[i] = tx_frames[i].Get();
+        snapshot.rx_frame_bytes[i] = rx_frame_bytes[i].Get();
+        snapshot.tx_frame_bytes[i] = tx_frame_bytes[i].Get();
+    }
+}
+
+static void AppendText(std::string& out, const char* name, const char* type, uint32_t value)
+{
+    char line[96];
+    snprintf(line, sizeof(line), "# TYPE %s %s\n%s %lu\n", name, type, name,
+             static_cast<unsigned long>(value));
+    out += line;
+}
+
+static void AppendText(std::string& out, const char* name, const uint32_t* values)
+{
+    char line[96];
+    snprintf(line, sizeof(line), "# TYPE %s counter\n", name);
+    out += line;
+
+    for (uint8_t i = 0; i < RXBEE_METRICS_API_SLOTS; ++i)
+    {
+        if (values[i] > 0)
+        {
+            if (slot_ids[i] == ApiID::UNKOWN)
+            {
+                snprintf(line, sizeof(line), "%s{api=\"other\"} %lu\n", name,
+                         static_cast<unsigned long>(values[i]));
+            }
+            else
+            {
+                snprintf(line, sizeof(line), "%s{api=\"0x%02X\"} %lu\n", name,
+                         static_cast<unsigned>(slot_ids[i]), static_cast<unsigned long>(values[i]));
+            }
+            out += line;
+        }
+    }
+}
+
+void Metrics::ExportText(const MetricsSnapshot& snapshot, std::string& out)
+{
+    AppendText(out, "rxbee_rx_bytes_total", "counter", snapshot.rx_bytes);
+    AppendText(out, "rxbee_tx_bytes_total", "counter", snapshot.tx_bytes);
+    AppendText(out, "rxbee_rx_escapes_total", "counter", snapshot.rx_escapes);
+    AppendText(out, "rxbee_tx_escapes_total", "counter", snapshot.tx_escapes);
+    AppendText(out, "rxbee_checksum_failures_total", "counter", snapshot.checksum_failures);
+    AppendText(out, "rxbee_discarded_bytes_total", "counter", snapshot.discarded_bytes);
+    AppendText(out, "rxbee_corrupt_frames_total", "counter", snapshot.corrupt_frames);
+    AppendText(out, "rxbee_resyncs_total", "counter", snapshot.resyncs);
+    AppendText(out, "rxbee_rx_overruns_total", "counter", snapshot.rx_overruns);
+    AppendText(out, "rxbee_rx_ring_high_water_bytes", "gauge", snapshot.rx_high_water);
+    AppendText(out, "rxbee_transactions_created_total", "counter", snapshot.transactions_created);
+    AppendText(out, "rxbee_transactions_completed_total", "counter", snapshot.transactions_completed);
+    AppendText(out, "rxbee_transactions_timed_out_total", "counter", snapshot.transactions_timed_out);
+    AppendText(out, "rxbee_transactions_retried_total", "counter", snapshot.transactions_retried);
+    AppendText(out, "rxbee_transactions_overflowed_total", "counter", snapshot.transactions_overflowed);
+    AppendText(out, "rxbee_rx_frames_total", snapshot.rx_frames);
+    AppendText(out, "rxbee_tx_frames_total", snapshot.tx_frames);
+    AppendText(out, "rxbee_rx_frame_bytes_total", snapshot.rx_frame_bytes);
+    AppendText(out, "rxbee_tx_frame_bytes_total", snapshot.tx_frame_bytes);
+}
+
+static void AppendBinary(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void Metrics::ExportBinary(const MetricsSnapshot& snapshot, std::vector<uint8_t>& out)
+{
+    out.push_back(RXBEE_METRICS_BINARY_VERSION);
+    AppendBinary(out, snapshot.rx_bytes);
+    AppendBinary(out, snapshot.tx_bytes);
+    AppendBinary(out, snapshot.rx_escapes);
+    AppendBinary(out, snapshot.tx_escapes);
+    AppendBinary(out, snapshot.checksum_failures);
+    AppendBinary(out, snapshot.discarded_bytes);
+    AppendBinary(out, snapshot.corrupt_frames);
+    AppendBinary(out, snapshot.resyncs);
+    AppendBinary(out, snapshot.rx_overruns);
+    AppendBinary(out, snapshot.rx_high_water);
+    AppendBinary(out, snapshot.transactions_created);
+    AppendBinary(out, snapshot.transactions_completed);
+    AppendBinary(out, snapshot.transactions_timed_out);
+    AppendBinary(out, snapshot.transactions_retried);
+    AppendBinary(out, snapshot.transactions_overflowed);
+
+    const uint32_t* per_api[] = { snapshot.rx_frames, snapshot.tx_frames,
+                                  snapshot.rx_frame_bytes, snapshot.tx_frame_bytes };
+    for (uint8_t c = 0; c < 4; ++c)
+    {
+        for (uint8_t i = 0; i < RXBEE_METRICS_API_SLOTS; ++i)
+        {
+            AppendBinary(out, per_api[c][i]);
+        }
+    }
+}
+
+} // namespace RXBee
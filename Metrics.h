@@ -0,0 +1,111 @@
+#ifndef RXBEE_METRICS_H
+#define RXBEE_METRICS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+#include "SpscRing.h"
+
+#define RXBEE_METRICS_API_SLOTS     (16)    // Known API IDs plus one for the rest
+#define RXBEE_METRICS_BINARY_VERSION (2)
+
+namespace RXBee
+{
+
+// Event counter costing one relaxed increment. With RXBEE_THREADED several
+// threads may add to it, otherwise one writer and any reader.
+class Counter
+{
+public:
+    Counter() : value(0) {}
+
+#if RXBEE_THREADED
+    void Add(uint32_t n) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t Get() const { return value.load(std::memory_order_relaxed); }
+    // Single writer
+    void Raise(uint32_t v) { if (v > Get()) value.store(v, std::memory_order_relaxed); }
+#else
+    void Add(uint32_t n) { value += n; }
+    uint32_t Get() const { return value; }
+    void Raise(uint32_t v) { if (v > value) value = v; }
+#endif
+
+    void Increment() { Add(1); }
+
+private:
+    Shared<uint32_t> value;
+};
+
+// Copy of every counter at one point in time. Per API counters are indexed
+// by Metrics::GetSlot, Metrics::GetSlotApiID gives the API ID of a slot.
+struct MetricsSnapshot
+{
+    uint32_t rx_bytes;                  // Serial bytes accepted by OnNext
+    uint32_t tx_bytes;                  // Serial bytes written, escapes included
+    uint32_t rx_escapes;                // Escape bytes removed
+    uint32_t tx_escapes;                // Escape bytes added
+    uint32_t checksum_failures;
+    uint32_t discarded_bytes;           // Skipped looking for a start byte
+    uint32_t corrupt_frames;            // Dropped, checksum failures included
+    uint32_t resyncs;                   // Runs of bytes skipped to find a start byte
+    uint32_t rx_overruns;
+    uint32_t rx_high_water;             // Most bytes waiting in the receive ring
+    uint32_t transactions_created;
+    uint32_t transactions_completed;    // Error responses included, see GetError
+    uint32_t transactions_timed_out;
+    uint32_t transactions_retried;
+    uint32_t transactions_overflowed;   // Cleared at RXBEE_MAX_TRANSACTIONS
+    uint32_t rx_frames[RXBEE_METRICS_API_SLOTS];
+    uint32_t tx_frames[RXBEE_METRICS_API_SLOTS];
+    uint32_t rx_frame_bytes[RXBEE_METRICS_API_SLOTS];   // Unescaped, framing included
+    uint32_t tx_frame_bytes[RXBEE_METRICS_API_SLOTS];
+};
+
+// Counters on the receive and transmit paths of XBeeNetwork. They are
+// always on, each event costs one increment and snapshots can be taken
+// from any thread.
+class Metrics
+{
+public:
+    Metrics();
+
+    void GetSnapshot(MetricsSnapshot& snapshot) const;
+
+    static uint8_t GetSlot(ApiID id);
+
+    // ApiID::UNKOWN for the slot collecting unlisted API IDs
+    static ApiID GetSlotApiID(uint8_t slot);
+
+    // Prometheus text exposition format, appended to out
+    static void ExportText(const MetricsSnapshot& snapshot, std::string& out);
+
+    // Version byte, then every counter in MetricsSnapshot order as a 32 bit
+    // big endian value, per API counters one slot after the other
+    static void ExportBinary(const MetricsSnapshot& snapshot, std::vector<uint8_t>& out);
+
+    Counter rx_bytes;
+    Counter tx_bytes;
+    Counter rx_escapes;
+    Counter tx_escapes;
+    Counter checksum_failures;
+    Counter discarded_bytes;
+    Counter corrupt_frames;
+    Counter resyncs;
+    Counter rx_overruns;
+    Counter rx_high_water;
+    Counter transactions_created;
+    Counter transactions_completed;
+    Counter transactions_timed_out;
+    Counter transactions_retried;
+    Counter transactions_overflowed;
+    Counter rx_frames[RXBEE_METRICS_API_SLOTS];
+    Counter tx_frames[RXBEE_METRICS_API_SLOTS];
+    Counter rx_frame_bytes[RXBEE_METRICS_API_SLOTS];
+    Counter tx_frame_bytes[RXBEE_METRICS_API_SLOTS];
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_METRICS_H
@@ -8,20 +8,63 @@
 #include "NetworkObserver.h"
 
 #define RXBEE_MAX_FRAME_COUNT  (0xFF) // Maximum frame id before rollover
+#define RXBEE_NODE_AGING_INTERVAL (1000) // Milliseconds between directory expiry
 
 namespace RXBee
 {
 
-char print_buffer[256];
+
+// ND and FN responses share the same layout
+template<typename T>
+static NodeRecord ToNodeRecord(const T& rsp, uint32_t now)
+{
+    NodeRecord node;
+    node.address = rsp.address;
+    strncpy(node.node_identifier, rsp.node_identifier, XBEE_AT_NI_IDENT_LEN);
+    node.node_identifier[XBEE_AT_NI_IDENT_LEN] = '\0';
+    node.device_type = rsp.device_type;
+    node.profile_id = rsp.profile_id;
+    node.mfr_id = rsp.mfr_id;
+    node.digi_device_type = rsp.digi_device_type;
+    node.rssi = rsp.last_hop_rssi;
+    node.last_seen = now;
+    return node;
+}
+
+static const NetworkLimits default_limits =
+{
+    RXBEE_RX_BUFFER_SIZE,
+    RXBEE_MAX_TRANSACTIONS,
+    RXBEE_FIRST_ATTEMPT_TIMEOUT,
+    RXBEE_TRANSACTION_TIMEOUT,
+    RXBEE_TRANSACTION_RETRY
+};
 
 XBeeNetwork::XBeeNetwork()
-    : network_status(ModemStatus::UNKNOWN),
-      rx_buff_head_index(0), rx_buff_tail_index(0),
-      tx_buff_index(0), frame_count(0),
-      frame_count_rollover(0), api_mode(ApiMode::ESCAPED),
-      print_handler(NULL), max_packet_payload_bytes(0x3D)
+    : XBeeNetwork(default_limits, NULL)
 {
+    
+}
+
+XBeeNetwork::XBeeNetwork(const NetworkLimits& limits, uint8_t* rx_buffer)
+    : network_status(ModemStatus::UNKNOWN), frame_count(0),
+      frame_count_rollover(0), uptime(0), directory_aged(0),
+      discovery(this), coalescer(this), unpacking(false),
+      io_handler(NULL), io_context(NULL), resolution_count(0),
+      limits(limits), rx_ring(GetRxStorage(rx_buffer, limits.rx_buffer_size),
+                              limits.rx_buffer_size),
+      rx_overrun(false), capture(NULL), tx_buff_index(0),
+      print_handler(NULL), submit_handler(NULL), submit_context(NULL),
+      api_mode(ApiMode::ESCAPED), max_packet_payload_bytes(0x3D)
+{
+#if RXBEE_FIXED_API_MODE >= 0
+    api_mode = static_cast<ApiMode>(RXBEE_FIXED_API_MODE);
+#endif
     rx_frame.Initialize(api_mode);
+    directory.OnRemoved(HandleNodeRemoved, this);
+#if RXBEE_HISTOGRAMS
+    latency_clock = NULL;
+#endif
 }
 
 
@@ -30,62 +73,205 @@ XBeeNetwork::~XBeeNetwork()
 
 }
 
+uint8_t* XBeeNetwork::GetRxStorage(uint8_t* rx_buffer, uint16_t size)
+{
+    uint8_t* storage = rx_buffer;
+    
+#if RXBEE_MIRRORED_RING && defined(__linux__)
+    (void)size;
+#else
+    if ((storage == NULL) && (size <= RXBEE_RX_BUFFER_SIZE))
+    {
+        storage = rx_buff;
+    }
+#endif
+    
+    return storage;
+}
+
 
 void XBeeNetwork::Service(uint32_t milliseconds)
 {
     uint16_t i = 0;    
-    uint16_t buff_max = rx_buff_tail_index;
-//    
-//    sprintf(print_buffer, "RXBee milliseconds [%d]", milliseconds);
-//    Print(print_buffer);
-//    
-    if (pending.size() >= RXBEE_MAX_TRANSACTIONS)
-    {
-        for (;i < pending.size(); ++i)
+#if RXBEE_HISTOGRAMS
+    uint32_t service_start = (latency_clock != NULL) ? latency_clock() : 0;
+#endif
+#if RXBEE_THREADED
+    AdoptSubmissions();
+#endif
+    
+    uptime += milliseconds;
+    
+    if ((uptime - directory_aged) >= RXBEE_NODE_AGING_INTERVAL)
+    {
+        directory.Expire(uptime, RXBEE_NODE_MAX_AGE);
+        topology.Expire(uptime, RXBEE_TOPOLOGY_MAX_AGE);
+        directory_aged = uptime;
+    }
+    
+    discovery.Service(uptime);
+    coalescer.Service(uptime);
+    
+    if (rx_overrun)
+    {
+        // Overrun, reset rx_frame and rx_buff
+        rx_overrun = false;
+        rx_frame.Initialize(api_mode);
+        rx_ring.Clear();
+        metrics.rx_overruns.Increment();
+        RXBEE_LOG_WARNING(this, LogID::RX_OVERRUN);
+    }
+    
+    if (pending.size() >= limits.max_transactions)
+    {
+        // Handlers may begin new transactions, those go to the empty list
+        std::vector<Transaction*> cleared;
+        cleared.swap(pending);
+        
+        for (;i < cleared.size(); ++i)
         {
-            if (pending[i] != NULL)
+            // Chained links may already have failed with an earlier one
+            if ((cleared[i] != NULL) && (cleared[i]->GetState() != Transaction::State::FREE))
             {
-                pending[i]->CompleteWithError(Transaction::Error::TRANSACTION_OVERFLOW);            
-                delete pending[i];
+                cleared[i]->CompleteWithError(Transaction::Error::TRANSACTION_OVERFLOW);
+                metrics.transactions_overflowed.Increment();
             }
         }
         
-        pending.clear();
-        Print("RXBee: Transactions cleared!");
+        for (i = 0; i < cleared.size(); ++i)
+        {
+            delete cleared[i];
+        }
+        
+        RXBEE_LOG_ERROR(this, LogID::TRANSACTIONS_CLEARED);
     }
     
     
-    // Set max buff index to RXBEE_RX_BUFFER_SIZE if the
-    // head index is greater than the tail
-    if (rx_buff_head_index > rx_buff_tail_index)
-    {
-        buff_max = RXBEE_RX_BUFFER_SIZE;
-    }
+    // Received bytes, in one segment when the ring is mirrored, otherwise
+    // the part after the end of the buffer follows in the second
+    RingView view;
+    rx_ring.GetReadView(view);
+    
+    metrics.rx_high_water.Raise(view.first_len + view.second_len);
     
-    // Read from receive buffer until head index equals tail index
-    while (rx_buff_head_index != rx_buff_tail_index)
+    const uint8_t* segment = view.first;
+    uint16_t segment_len = view.first_len;
+    uint16_t index = 0;
+    
+    while (index < segment_len)
     {
-        uint16_t tmp_head_idx = rx_buff_head_index;
-        // Read up to maximum from receive buffer
-        if (rx_frame.Deserialize(rx_buff, buff_max, rx_buff_head_index))
+        // Deserialize reads until a frame is complete or the segment ends.
+        // The ring keeps the bytes until Consume, so unescaped frames inside
+        // the segment, every frame when mirrored, are parsed in place.
+        bool complete = rx_frame.Deserialize(segment, segment_len, index, true);
+        
+        metrics.rx_escapes.Add(rx_frame.GetEscapedCount());
+        metrics.discarded_bytes.Add(rx_frame.GetDiscardedCount());
+        metrics.corrupt_frames.Add(rx_frame.GetCorruptedCount());
+        metrics.resyncs.Add(rx_frame.GetResyncCount());
+        rx_frame.ResetCounts();
+        
+        if (complete)
         {
-            // Complete frame received
+            // Complete frame received, a corrupted one is dropped and the
+            // next call hunts for the following start byte
+            bool valid = rx_frame.Validate();
+            if (valid)
+            {
+                uint8_t slot = Metrics::GetSlot(rx_frame.GetApiID());
+                metrics.rx_frames[slot].Increment();
+                metrics.rx_frame_bytes[slot].Add(rx_frame.GetSize() + XBEE_FRAMING_SIZE);
+            }
+            else
+            {
+                metrics.checksum_failures.Increment();
+                metrics.corrupt_frames.Increment();
+            }
          
             Response::ApiFrame api_frame (&rx_frame);
-            if (api_frame.extracted == true)
+            if (valid && (api_frame.extracted == true))
             {  
                 if (api_frame.api_id == ApiID::RECEIVE_PACKET)
                 {
                     // Received serial data
                     std::vector<uint8_t> frame_data;
                     Response::ReceivePacket packet(api_frame, frame_data);
-                    SerialDataReceived(packet.sender_addr, frame_data); // Notify observers
+                    if (directory.Touch(packet.sender_addr, uptime) == NodeDirectory::Change::INSERTED)
+                    {
+                        NodeJoined(*directory.Find(packet.sender_addr));
+                    }
+                    
+                    Deliver(packet.sender_addr, frame_data);
+                }
+                else if (api_frame.api_id == ApiID::EXPLICIT_RX_INDICATOR)
+                {
+                    // Received serial data addressed to an endpoint
+                    std::vector<uint8_t> frame_data;
+                    Response::ExplicitReceivePacket packet(api_frame, frame_data);
+                    if (packet.extracted)
+                    {
+                        if (directory.Touch(packet.sender_addr, uptime) == NodeDirectory::Change::INSERTED)
+                        {
+                            NodeJoined(*directory.Find(packet.sender_addr));
+                        }
+
+                        if (!endpoints.Dispatch(this, packet, frame_data))
+                        {
+                            Deliver(packet.sender_addr, frame_data);
+                        }
+                    }
+                }
+                else if (api_frame.api_id == ApiID::IO_DATA_SAMPLE_RX_INDICATOR)
+                {
+                    Response::ExplicitIOSample sample(api_frame);
+                    if (sample.extracted)
+                    {
+                        if (directory.Touch(sample.source_addr, uptime) == NodeDirectory::Change::INSERTED)
+                        {
+                            NodeJoined(*directory.Find(sample.source_addr));
+                        }
+                        
+                        if (io_handler != NULL)
+                        {
+                            if (io_batch.IsFull())
+                            {
+                                FlushIOSamples();
+                            }
+                            io_batch.Add(sample, uptime);
+                        }
+                    }
+                }
+                else if (api_frame.api_id == ApiID::ROUTE_INFO_PACKET)
+                {
+                    Response::RouteInformation route(api_frame);
+                    if (route.extracted)
+                    {
+                        topology.Record(route, uptime);
+                    }
                 }
                 else if (api_frame.api_id == ApiID::MODEM_STATUS)
                 {
                     Response::ModemStatusUpdate modem_status(api_frame);
                     StatusChanged(modem_status.status);
                 }
+                else if (api_frame.api_id == ApiID::NODE_ID_INDICATOR)
+                {
+                    Response::NodeID node_id(api_frame);
+                    if (node_id.extracted)
+                    {
+                        NodeRecord node;
+                        node.address = node_id.remote_addr;
+                        strncpy(node.node_identifier, node_id.identifier, XBEE_AT_NI_IDENT_LEN);
+                        node.node_identifier[XBEE_AT_NI_IDENT_LEN] = '\0';
+                        node.device_type = static_cast<uint8_t>(node_id.type);
+                        node.profile_id = node_id.digi_profile_id;
+                        node.mfr_id = node_id.digi_mfr_id;
+                        node.digi_device_type = node_id.digi_dd_value;
+                        node.rssi = node_id.rssi_included ? static_cast<uint8_t>(node_id.rssi) : 0;
+                        node.last_seen = uptime;
+                        UpdateNode(node);
+                    }
+                }
                 else
                 {
                     uint16_t p = 0; 
@@ -116,11 +302,23 @@ void XBeeNetwork::Service(uint32_t milliseconds)
 
                                 if (rsp.address != local_addr)
                                 {
+                                    UpdateNode(ToNodeRecord(rsp, uptime));
+                                    
                                     std::string id(rsp.node_identifier);
                                     DeviceDiscovered(rsp.address, id);
                                 }
                                 break;
                             }
+                            case XBeeATCommand::FN:
+                            {
+                                Response::ATCommand::FN_Rsp rsp = at_rsp.FN();
+                                
+                                if ((rsp.address != 0) && (rsp.address != local_addr))
+                                {
+                                    UpdateNode(ToNodeRecord(rsp, uptime));
+                                }
+                                break;
+                            }
                             case XBeeATCommand::ID:
                             {
                                 Response::ATCommand::ID_Rsp rsp = at_rsp.ID();
@@ -167,28 +365,22 @@ void XBeeNetwork::Service(uint32_t milliseconds)
                 }
             }
             
-            // reset the receive frame
+            // reset the receive frame, then parse the next one
             rx_frame.Initialize(api_mode);
-            break;
-        }
-        else if (tmp_head_idx == rx_buff_head_index)
-        {
-            // Did not deserialize any more data, wait for more
-            break;
-        }
-        else
-        {
-            // Nothing
         }
         
-        // Reset head index when it reaches the end of the buffer
-        if (rx_buff_head_index >= RXBEE_RX_BUFFER_SIZE)
+        // Continue at the front of the buffer
+        if ((index >= segment_len) && (segment == view.first))
         {
-            rx_buff_head_index = 0;         // Start at front of buffer
-            buff_max = rx_buff_tail_index;  // Max is now the tail index
+            segment = view.second;
+            segment_len = view.second_len;
+            index = 0;
         }
     }
     
+    // Return consumed bytes to the reader
+    rx_ring.Consume(view.first_len + view.second_len);
+    
     i = 0;
     for (; i < pending.size(); ++i)
     {                
@@ -197,15 +389,15 @@ void XBeeNetwork::Service(uint32_t milliseconds)
         {
             if (pending[i]->Retry())
             {
-                sprintf(print_buffer, "RXBee: Transaction Timeout, Retrying : %d", i);
-                Print(print_buffer);
+                metrics.transactions_retried.Increment();
+                RXBEE_LOG_INFO(this, LogID::TRANSACTION_RETRY, i);
                 break;
             }
             else
             {
                 pending[i]->CompleteWithError(Transaction::Error::TRANSACTION_TIMEOUT);
-                sprintf(print_buffer, "RXBee: ERROR Transaction Timeout : %d", i);
-                Print(print_buffer);
+                metrics.transactions_timed_out.Increment();
+                RXBEE_LOG_ERROR(this, LogID::TRANSACTION_TIMEOUT, i);
             }
         }
     }
@@ -222,15 +414,18 @@ void XBeeNetwork::Service(uint32_t milliseconds)
         }
     }
     
-    if (i >= pending.size())
+    if (i < pending.size())
+    {  
+        SendBurst(pending[i]);
+    }
+    else
     {
         std::vector<Address> exclusion;
-        bool exclude = false;
-        // Send pending transactions
+        // Send pending transactions, one in flight per destination
         i = 0;
         for (; i < pending.size(); ++i)
         {
-            if (pending[i]->GetState() == Transaction::State::SENT)
+            if (pending[i]->IsInFlight())
             {
                 exclusion.push_back(pending[i]->GetDestination());
             }
@@ -240,7 +435,15 @@ void XBeeNetwork::Service(uint32_t milliseconds)
         { 
             if (pending[i]->GetState() == Transaction::State::PENDING)
             {
-                for (uint16_t e = 0; e < exclusion.size(); ++e)
+                bool exclude = false;
+                
+                if ((pending[i]->GetDestination() & RXBEE_UNRESOLVED_ADDRESS_MASK) == RXBEE_UNRESOLVED_ADDRESS)
+                {
+                    // Addressed by name, waits for its lookup
+                    exclude = !ResolveDestination(pending[i]);
+                }
+                
+                for (uint16_t e = 0; (e < exclusion.size()) && !exclude; ++e)
                 {
                     if (pending[i]->GetDestination() == exclusion[e])
                     {
@@ -251,39 +454,134 @@ void XBeeNetwork::Service(uint32_t milliseconds)
             
                 if (!exclude)
                 {
-                    break;
+                    // Different destinations go out in the same call
+                    exclusion.push_back(pending[i]->GetDestination());
+                    SendBurst(pending[i]);
                 }
             }
         }
     }
     
-    if (i < pending.size())
-    {  
-        frame_count++;
-
-        Frame* f = pending[i]->GetFrame();
+    if (!resolutions.empty())
+    {
+        ReleaseResolutions();
+    }
+    
+    FlushIOSamples();
+    
+#if RXBEE_HISTOGRAMS
+    if (latency_clock != NULL)
+    {
+        latency.RecordService(latency_clock() - service_start);
+    }
+#endif
+}
 
-        f->SetFrameID(frame_count);
+void XBeeNetwork::OnIOSamples(IOSampleHandler handler, void* context)
+{
+    io_handler = handler;
+    io_context = context;
+    io_batch.Clear();
+}
 
-        // Write frame to transmit buffer 
-        subject.Next(f->Serialize());
+void XBeeNetwork::FlushIOSamples()
+{
+    if ((io_batch.count > 0) && (io_handler != NULL))
+    {
+        io_handler(this, io_batch, io_context);
+    }
+    io_batch.Clear();
+}
 
-        // Transaction sent
-        pending[i]->Sent(frame_count);
-#if RXBEE_DEBUG
-        uint64_t dest_addr = pending[i]->GetDestination();
-        uint32_t frame_id = pending[i]->GetFrameID();
-        sprintf(print_buffer, "RXBee: Transaction[%d] sent to %llx, id => %d", i, dest_addr, frame_id);
-        Print(print_buffer);
-#endif
-        // Increment frame count
-        if (frame_count == RXBEE_MAX_FRAME_COUNT)
+void XBeeNetwork::ReleaseResolutions()
+{
+    for (uint16_t r = 0; r < resolutions.size();)
+    {
+        bool referenced = (resolutions[r].state == ResolveState::LOOKUP);
+        
+        for (uint16_t p = 0; (p < pending.size()) && !referenced; ++p)
         {
-            // Handler overflow
-            frame_count = 0;
-            frame_count_rollover++;
+            referenced = (pending[p]->GetState() != Transaction::State::FREE) &&
+                         (pending[p]->GetDestination() == resolutions[r].placeholder);
         }
+        
+        if (referenced)
+        {
+            ++r;
+        }
+        else
+        {
+            resolutions.erase(resolutions.begin() + r);
+        }
+    }
+}
+
+void XBeeNetwork::SendBurst(Transaction* t)
+{
+    Send(t);
+
+    // Queued commands follow in the same burst, a retried command is
+    // resent on its own
+    Transaction* b = t->retried ? NULL : t->GetNext();
+    while ((b != NULL) && b->batched && (b->GetState() == Transaction::State::FRAMED))
+    {
+        Send(b);
+        b = b->GetNext();
+    }
+}
+
+void XBeeNetwork::Send(Transaction* t)
+{
+    frame_count++;
+
+    Frame* f = t->GetFrame();
+
+    f->SetFrameID(frame_count);
+
+    // Write frame to transmit buffer 
+    WriteFrame(*f);
+
+    // Transaction sent
+    t->Sent(frame_count);
+    RXBEE_LOG_DEBUG(this, LogID::TRANSACTION_SENT, t->GetDestination() >> 32,
+                    t->GetDestination(), t->GetFrameID());
+    // Increment frame count
+    if (frame_count == RXBEE_MAX_FRAME_COUNT)
+    {
+        // Handler overflow
+        frame_count = 0;
+        frame_count_rollover++;
+    }
+}
+
+void XBeeNetwork::WriteFrame(const Frame& f)
+{
+    std::vector<uint8_t> serial_data = f.Serialize();
+    uint16_t frame_bytes = serial_data.size();
+    
+    if (api_mode != ApiMode::TRANSPARENT)
+    {
+        frame_bytes = f.GetSize() + XBEE_FRAMING_SIZE;
+    }
+    
+    uint8_t slot = Metrics::GetSlot(f.GetApiID());
+    metrics.tx_frames[slot].Increment();
+    metrics.tx_frame_bytes[slot].Add(frame_bytes);
+    metrics.tx_bytes.Add(serial_data.size());
+    metrics.tx_escapes.Add(serial_data.size() - frame_bytes);
+    
+    WireCapture* c = capture;
+    if (c != NULL)
+    {
+        c->Record(RXBEE_CAPTURE_TX, &serial_data[0], serial_data.size());
     }
+    
+    subject.Next(serial_data);
+}
+
+uint32_t XBeeNetwork::GetUptime() const
+{
+    return uptime;
 }
 
 uint64_t XBeeNetwork::GetTotalTransactions() const
@@ -299,15 +597,107 @@ SerialDataSubject* XBeeNetwork::GetSerialDataSubject()
 
 Transaction* XBeeNetwork::DiscoverAsync()
 {
-    BeginTransaction()->ReadAddressUpper()->ReadAddressLower()->NetworkDiscover()->Pend();
+    return BeginTransaction()->ReadAddressUpper()->ReadAddressLower()->NetworkDiscover()->Pend();
 }
 
 
+void XBeeNetwork::StartDiscovery(uint32_t interval, uint16_t backoff, uint8_t options)
+{
+    discovery.Start(interval, backoff, options);
+}
+
+void XBeeNetwork::StopDiscovery()
+{
+    discovery.Stop();
+}
+
 void XBeeNetwork::OnStatusChanged(XBeeNetwork::Callback callback)
 {
     status_changed_cb = callback;
 }
 
+void XBeeNetwork::OnSubmit(XBeeNetwork::SubmitHandler handler, void* context)
+{
+    submit_handler = handler;
+    submit_context = context;
+}
+
+int32_t XBeeNetwork::GetNextTimeout()
+{
+    int32_t timeout = -1;
+    
+#if RXBEE_THREADED
+    AdoptSubmissions();
+#endif
+    
+    if (rx_ring.GetHead() != rx_ring.GetTail())
+    {
+        timeout = 0;    // Received bytes not yet parsed
+    }
+    
+    int32_t sweep = discovery.GetNextTimeout(uptime);
+    if ((sweep >= 0) && ((timeout < 0) || (sweep < timeout)))
+    {
+        timeout = sweep;
+    }
+    
+    int32_t batch = coalescer.GetNextTimeout(uptime);
+    if ((batch >= 0) && ((timeout < 0) || (batch < timeout)))
+    {
+        timeout = batch;
+    }
+    
+    for (uint16_t i = 0; (i < pending.size()) && (timeout != 0); ++i)
+    {
+        Transaction* t = pending[i];
+        
+        if (t->GetState() == Transaction::State::CHAINED)
+        {
+            timeout = 0;
+        }
+        else if (t->GetState() == Transaction::State::PENDING)
+        {
+            bool blocked = false;
+            
+            // Waiting for a name lookup
+            for (uint16_t r = 0; r < resolutions.size(); ++r)
+            {
+                if ((resolutions[r].placeholder == t->GetDestination()) &&
+                    (resolutions[r].state == ResolveState::LOOKUP))
+                {
+                    blocked = true;
+                    break;
+                }
+            }
+            
+            // Ready unless a transaction to the same destination is in flight
+            for (uint16_t e = 0; (e < pending.size()) && !blocked; ++e)
+            {
+                if (pending[e]->IsInFlight() &&
+                    (pending[e]->GetDestination() == t->GetDestination()))
+                {
+                    blocked = true;
+                    break;
+                }
+            }
+            
+            if (!blocked)
+            {
+                timeout = 0;
+            }
+        }
+        else if ((t->GetState() == Transaction::State::SENT) && t->apply_timeout)
+        {
+            if ((timeout < 0) || (t->timeout_remaining < timeout))
+            {
+                timeout = t->timeout_remaining;
+            }
+        }
+    }
+    
+    return timeout;
+}
+
 ModemStatus XBeeNetwork::GetStatus()
 {
     return network_status;
@@ -333,8 +723,26 @@ ApiMode XBeeNetwork::GetApiMode()
     return api_mode;
 }
 
+void XBeeNetwork::SetApiMode(ApiMode mode)
+{
+#if RXBEE_FIXED_API_MODE < 0
+    api_mode = mode;
+#else
+    (void)mode;
+#endif
+    rx_frame.Initialize(api_mode);
+}
+
 Transaction* XBeeNetwork::BeginTransaction(Address addr)
 {
+#if RXBEE_THREADED
+    // The pending list belongs to the Service thread, the transaction
+    // joins it when pended (see AdoptSubmissions)
+    Transaction* t = new Transaction();
+    t->Initialize(addr, this);
+    metrics.transactions_created.Increment();
+    return t;
+#else
     uint16_t i = 0; 
     Transaction* t = NULL;
     
@@ -358,20 +766,35 @@ Transaction* XBeeNetwork::BeginTransaction(Address addr)
             
     if (t != NULL)
     {
-        
-#if RXBEE_DEBUG
-        sprintf(print_buffer, "RXBee: Transaction created[%d]", i);
-        Print(print_buffer);
-#endif
+        RXBEE_LOG_DEBUG(this, LogID::TRANSACTION_CREATED, i);
         t->Initialize(addr, this);
+        metrics.transactions_created.Increment();
     }
     
     return t;
+#endif
 }
 
 Transaction* XBeeNetwork::BeginTransaction()
 {
-    return BeginTransaction(RXBEE_LOCAL_ADDRESS);
+    return BeginTransaction(static_cast<Address>(RXBEE_LOCAL_ADDRESS));
+}
+
+Transaction* XBeeNetwork::BeginTransaction(const char* node_identifier)
+{
+    const NodeRecord* node = directory.Find(node_identifier);
+    Address addr;
+    
+    if (node != NULL)
+    {
+        addr = node->address;
+    }
+    else
+    {
+        addr = Resolve(node_identifier);
+    }
+    
+    return BeginTransaction(addr);
 }
 
 Transaction* XBeeNetwork::BeginBroadcastTransaction()
@@ -379,41 +802,198 @@ Transaction* XBeeNetwork::BeginBroadcastTransaction()
     return BeginTransaction(XBEE_BROADCAST_ADDRESS);
 }
 
-void XBeeNetwork::SerialDataReceived(const uint64_t source_addr, const std::vector<uint8_t>& data)
+Address XBeeNetwork::Resolve(const char* node_identifier)
 {
-    for(uint16_t i = 0; i < subscribers.size(); ++i)
+    uint16_t r = 0;
+    
+    for (; r < resolutions.size(); ++r)
     {
-        subscribers[i]->OnSerialDataReceived(source_addr, data);
+        if ((resolutions[r].state == ResolveState::LOOKUP) &&
+            (strncmp(resolutions[r].node_identifier, node_identifier, XBEE_AT_NI_IDENT_LEN) == 0))
+        {
+            // Queue behind the lookup in flight
+            break;
+        }
+    }
+    
+    if (r >= resolutions.size())
+    {
+        Resolution resolution;
+        resolution_count++;
+        resolution.placeholder = RXBEE_UNRESOLVED_ADDRESS | resolution_count;
+        resolution.address = RXBEE_UNRESOLVED_ADDRESS;
+        resolution.state = ResolveState::LOOKUP;
+        strncpy(resolution.node_identifier, node_identifier, XBEE_AT_NI_IDENT_LEN);
+        resolution.node_identifier[XBEE_AT_NI_IDENT_LEN] = '\0';
+        
+        Transaction* t = BeginTransaction()->WriteParameter(XBEE_CMD_FN, std::string(resolution.node_identifier));
+        
+        // Responses reach the directory, which completes the lookup
+        t->Collect(RXBEE_DISCOVERY_TIMEOUT, NULL, NULL);
+        t->OnComplete(HandleResolveComplete, this);
+        resolution.lookup = t;
+        resolutions.push_back(resolution);
+        t->Pend();
     }
+    
+    return resolutions[r].placeholder;
 }
 
-void XBeeNetwork::OnNext(const std::vector<uint8_t>& data)
+void XBeeNetwork::Resolved(const char* node_identifier, Address addr)
 {
-    OnNext(&data[0], data.size());
+    for (uint16_t r = 0; r < resolutions.size(); ++r)
+    {
+        if ((resolutions[r].state == ResolveState::LOOKUP) &&
+            (strncmp(resolutions[r].node_identifier, node_identifier, XBEE_AT_NI_IDENT_LEN) == 0))
+        {
+            resolutions[r].address = addr;
+            resolutions[r].state = ResolveState::RESOLVED;
+
+            // Only the named node answers, stop collecting
+            Transaction* lookup = resolutions[r].lookup;
+            if ((lookup != NULL) &&
+                ((lookup->GetState() == Transaction::State::SENT) ||
+                 (lookup->GetState() == Transaction::State::PENDING)))
+            {
+                lookup->Complete();
+            }
+        }
+    }
 }
 
-void XBeeNetwork::OnNext(const uint8_t* data, const uint16_t len)
+bool XBeeNetwork::ResolveDestination(Transaction* t)
+{
+    bool resolved = false;
+    
+    for (uint16_t r = 0; r < resolutions.size(); ++r)
+    {
+        if (resolutions[r].placeholder == t->GetDestination())
+        {
+            if (resolutions[r].state == ResolveState::RESOLVED)
+            {
+                t->Redirect(resolutions[r].address);
+                resolved = true;
+            }
+            else if (resolutions[r].state == ResolveState::FAILED)
+            {
+                t->CompleteWithError(Transaction::Error::INVALID_DESTINATION);
+            }
+            break;
+        }
+    }
+    
+    return resolved;
+}
+
+void XBeeNetwork::HandleResolveComplete(Transaction* transaction, void* context)
+{
+    XBeeNetwork* net = static_cast<XBeeNetwork*>(context);
+    
+    if (net != NULL)
+    {
+        for (uint16_t r = 0; r < net->resolutions.size(); ++r)
+        {
+            if (net->resolutions[r].lookup == transaction)
+            {
+                if (net->resolutions[r].state == ResolveState::LOOKUP)
+                {
+                    net->resolutions[r].state = ResolveState::FAILED;
+                }
+                net->resolutions[r].lookup = NULL;
+            }
+        }
+    }
+}
+
+void XBeeNetwork::Submit(Transaction* t)
 {
-    for(uint16_t i = 0; i < len; ++i)
+#if RXBEE_THREADED
+    while (t != NULL)
     {
-        rx_buff[rx_buff_tail_index] = data[i];
+        // The Service thread may own the link as soon as it is pushed
+        Transaction* next = t->next;
+        
+        if (!t->submitted)
+        {
+            t->submitted = true;
+            submissions.Push(t);
+        }
         
-        rx_buff_tail_index++;
+        t = next;
+    }
+#else
+    (void)t;
+#endif
+    
+    if (submit_handler != NULL)
+    {
+        submit_handler(this, submit_context);
+    }
+}
+
+#if RXBEE_THREADED
+void XBeeNetwork::AdoptSubmissions()
+{
+    Transaction* t = submissions.PopAll();
+    uint16_t i = 0;
+    
+    while (t != NULL)
+    {
+        Transaction* next = t->submit_next;
+        t->submit_next = NULL;
         
-        if (rx_buff_tail_index >= RXBEE_RX_BUFFER_SIZE)
+        // Reuse a free slot before growing the pending list
+        for (; i < pending.size(); ++i)
         {
-            rx_buff_tail_index = 0;
+            if (pending[i]->GetState() == Transaction::State::FREE)
+            {
+                break;
+            }
         }
         
-        if (rx_buff_tail_index == rx_buff_head_index)
+        if (i < pending.size())
         {
-            // Overrun, reset rx_frame and rx_buff
-            rx_frame.Initialize(api_mode);
-            Print("RXBee: RX overrun, buffer reset");
-            rx_buff_tail_index = 0;
-            rx_buff_head_index = 0;
-            break;
+            delete pending[i];
+            pending[i] = t;
+        }
+        else
+        {
+            pending.push_back(t);
         }
+        
+        t = next;
+    }
+}
+#endif
+
+void XBeeNetwork::SerialDataReceived(const uint64_t source_addr, const std::vector<uint8_t>& data)
+{
+    for(uint16_t i = 0; i < subscribers.size(); ++i)
+    {
+        subscribers[i]->OnSerialDataReceived(source_addr, data);
+    }
+}
+
+void XBeeNetwork::OnNext(const std::vector<uint8_t>& data)
+{
+    OnNext(&data[0], data.size());
+}
+
+void XBeeNetwork::OnNext(const uint8_t* data, const uint16_t len)
+{
+    WireCapture* c = capture;
+    if (c != NULL)
+    {
+        c->Record(RXBEE_CAPTURE_RX, data, len);
+    }
+    
+    uint16_t written = rx_ring.Write(data, len);
+    
+    metrics.rx_bytes.Add(written);
+    if (written < len)
+    {
+        // Overrun, the Service thread owns the frame state and resets it
+        rx_overrun = true;
     }
 }
     
@@ -443,11 +1023,230 @@ void XBeeNetwork::Print(const char* msg)
     if (print_handler != NULL) { print_handler(msg); }
 }
 
+void XBeeNetwork::Log(LogID id, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+    log.Write(uptime, id, a0, a1, a2);
+}
+
+uint16_t XBeeNetwork::DrainLog(uint16_t max)
+{
+    uint16_t count = 0;
+    LogRecord record;
+    char buffer[96];
+    
+    while ((count < max) && log.Read(record))
+    {
+        LogRing::Format(record, buffer, sizeof(buffer));
+        Print(buffer);
+        count++;
+    }
+    
+    return count;
+}
+
+bool XBeeNetwork::ReadLog(LogRecord& record)
+{
+    return log.Read(record);
+}
+
+uint32_t XBeeNetwork::GetLogDropped() const
+{
+    return log.GetDropped();
+}
+
 uint16_t XBeeNetwork::GetMaxPacketPayloadBytes() const
 {
     return max_packet_payload_bytes;
 }
 
+void XBeeNetwork::SetCoalescing(uint32_t delay_ms)
+{
+    coalescer.SetDelay(delay_ms);
+}
+
+void XBeeNetwork::SendMessage(Address dest, const uint8_t* data, uint16_t n)
+{
+    coalescer.Queue(dest, data, n, uptime);
+}
+
+void XBeeNetwork::FlushMessages()
+{
+    coalescer.FlushAll();
+}
+
+void XBeeNetwork::Deliver(Address source_addr, const std::vector<uint8_t>& data)
+{
+    std::vector<std::vector<uint8_t> > messages;
+    if (unpacking && codec.Unpack(source_addr, data, messages))
+    {
+        for (uint16_t m = 0; m < messages.size(); ++m)
+        {
+            SerialDataReceived(source_addr, messages[m]);
+        }
+    }
+    else
+    {
+        SerialDataReceived(source_addr, data); // Notify observers
+    }
+}
+
+bool XBeeNetwork::RegisterEndpoint(uint8_t endpoint, uint16_t cluster, uint16_t profile,
+                                   EndpointTable::Handler handler, void* context)
+{
+    return endpoints.Register(endpoint, cluster, profile, handler, context);
+}
+
+bool XBeeNetwork::UnregisterEndpoint(uint8_t endpoint, uint16_t cluster, uint16_t profile)
+{
+    return endpoints.Unregister(endpoint, cluster, profile);
+}
+
+void XBeeNetwork::SetUnpacking(bool enabled)
+{
+    unpacking = enabled;
+}
+
+void XBeeNetwork::SetCompression(bool enabled)
+{
+    codec.SetCompression(enabled);
+}
+
+PayloadCodec::Stats XBeeNetwork::GetCompressionStats() const
+{
+    return codec.GetStats();
+}
+
+uint16_t XBeeNetwork::FitPayload(const uint8_t* prefix, uint8_t prefix_n,
+                                 const uint8_t* buffer, uint16_t n) const
+{
+    uint16_t capacity = max_packet_payload_bytes;
+    bool escaped = (api_mode == ApiMode::ESCAPED);
+    uint16_t used = 0;
+    uint16_t fit = 0;
+    
+    if (escaped)
+    {
+        // Worst case of escaping length and checksum bytes
+        capacity -= 3;
+    }
+    
+    for (uint16_t i = 0; i < prefix_n + n; ++i)
+    {
+        uint8_t b = (i < prefix_n) ? prefix[i] : buffer[i - prefix_n];
+        uint16_t cost = 1;
+        
+        if (escaped &&
+            ((b == XBEE_PACKET_START) || (b == XBEE_ESCAPE_BYTE) ||
+             (b == XBEE_XON) || (b == XBEE_XOFF)))
+        {
+            cost = 2;
+        }
+        
+        if (used + cost > capacity)
+        {
+            break;
+        }
+        
+        used += cost;
+        if (i >= prefix_n)
+        {
+            fit++;
+        }
+    }
+    
+    // Always make progress
+    return ((fit == 0) && (n > 0)) ? 1 : fit;
+}
+
+bool XBeeNetwork::SendDatagram(Address dest, const uint8_t* data, uint16_t n,
+                               uint8_t radius, uint8_t options)
+{
+    bool sent = false;
+    
+    if (FitPayload(NULL, 0, data, n) == n)
+    {
+        // Frame ID 0, the radio reports no status and nothing is tracked
+        Frame f;
+        f.Initialize(ApiID::TRANSMIT_REQUEST, api_mode);
+        f.AddFields(dest,
+                    static_cast<uint16_t>(0xFFFE),
+                    radius,
+                    options);
+        f.AddData(data, n);
+        f.SetFrameID(0);
+        WriteFrame(f);
+        sent = true;
+    }
+    
+    return sent;
+}
+
+bool XBeeNetwork::Broadcast(const uint8_t* data, uint16_t n, uint8_t radius, uint8_t options)
+{
+    return SendDatagram(XBEE_BROADCAST_ADDRESS, data, n, radius, options);
+}
+
+const NodeDirectory* XBeeNetwork::GetNodeDirectory() const
+{
+    return &directory;
+}
+
+void XBeeNetwork::GetMetrics(MetricsSnapshot& snapshot) const
+{
+    metrics.GetSnapshot(snapshot);
+}
+
+#if RXBEE_HISTOGRAMS
+void XBeeNetwork::SetLatencyClock(XBeeNetwork::Clock clock)
+{
+    latency_clock = clock;
+}
+
+const LatencyStats& XBeeNetwork::GetLatencyStats() const
+{
+    return latency;
+}
+
+void XBeeNetwork::ResetLatencyStats()
+{
+    latency.Clear();
+}
+
+uint32_t XBeeNetwork::GetLatencyTime() const
+{
+    return (latency_clock != NULL) ? latency_clock() : uptime * 1000;
+}
+
+void XBeeNetwork::RecordLatency(const Transaction* t)
+{
+    if (t->sent_api != ApiID::UNKOWN)
+    {
+        uint32_t now = GetLatencyTime();
+        DestinationClass dest = LatencyStats::Classify(t->dest_addr);
+        
+        latency.Record(dest, t->sent_api, LatencyStage::BUILD, t->pended_at - t->initialized_at);
+        latency.Record(dest, t->sent_api, LatencyStage::QUEUE, t->sent_at - t->pended_at);
+        latency.Record(dest, t->sent_api, LatencyStage::RESPONSE, now - t->sent_at);
+        latency.Record(dest, t->sent_api, LatencyStage::TOTAL, now - t->initialized_at);
+    }
+}
+#endif
+
+const MeshTopology* XBeeNetwork::GetTopology() const
+{
+    return &topology;
+}
+
+void XBeeNetwork::SetCapture(WireCapture* capture)
+{
+    this->capture = capture;
+}
+
+const NetworkLimits& XBeeNetwork::GetLimits() const
+{
+    return limits;
+}
+
 void XBeeNetwork::DeviceDiscovered(Address address, const std::string& node_id)
 {
     for (uint16_t i = 0; i < subscribers.size(); ++i)
@@ -456,6 +1255,78 @@ void XBeeNetwork::DeviceDiscovered(Address address, const std::string& node_id)
     }
 }
 
+void XBeeNetwork::UpdateNode(const NodeRecord& node)
+{
+    NodeDirectory::Change change = directory.Update(node);
+    
+    if (!resolutions.empty())
+    {
+        // Any source naming the node completes its lookup
+        Resolved(node.node_identifier, node.address);
+    }
+    const NodeRecord* n = directory.Find(node.address);
+    
+    if (n != NULL)
+    {
+        if (change == NodeDirectory::Change::INSERTED)
+        {
+            NodeJoined(*n);
+        }
+        else if (change == NodeDirectory::Change::CHANGED)
+        {
+            NodeChanged(*n);
+        }
+    }
+}
+
+void XBeeNetwork::ForgetNode(Address addr)
+{
+    const NodeRecord* n = directory.Find(addr);
+    
+    if (n != NULL)
+    {
+        NodeRecord node = *n;
+        directory.Remove(addr);
+        topology.Remove(addr);
+        NodeLeft(node);
+    }
+}
+
+void XBeeNetwork::HandleNodeRemoved(const NodeRecord& node, void* context)
+{
+    XBeeNetwork* net = static_cast<XBeeNetwork*>(context);
+    
+    if (net != NULL)
+    {
+        net->topology.Remove(node.address);
+        net->NodeLeft(node);
+    }
+}
+
+void XBeeNetwork::NodeJoined(const NodeRecord& node)
+{
+    for (uint16_t i = 0; i < subscribers.size(); ++i)
+    {
+        subscribers[i]->OnNodeJoined(this, node);
+    }
+}
+
+void XBeeNetwork::NodeChanged(const NodeRecord& node)
+{
+    for (uint16_t i = 0; i < subscribers.size(); ++i)
+    {
+        subscribers[i]->OnNodeChanged(this, node);
+    }
+}
+
+void XBeeNetwork::NodeLeft(const NodeRecord& node)
+{
+    for (uint16_t i = 0; i < subscribers.size(); ++i)
+    {
+        subscribers[i]->OnNodeLeft(this, node);
+    }
+}
+
 void XBeeNetwork::StatusChanged(ModemStatus status)
 {
     ModemStatus prev = network_status;
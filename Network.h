@@ -13,6 +13,20 @@
 #include "Transaction.h"
 #include "Types.h"
 #include "SpecificResponses.h"
+#include "SpscRing.h"
+#include "SubmissionQueue.h"
+#include "Awaitable.h"
+#include "NodeDirectory.h"
+#include "NetworkDiscovery.h"
+#include "MessageCoalescer.h"
+#include "PayloadCodec.h"
+#include "EndpointTable.h"
+#include "IOSampling.h"
+#include "MeshTopology.h"
+#include "Metrics.h"
+#include "Histogram.h"
+#include "WireCapture.h"
+#include "Log.h"
 
 
 
@@ -21,11 +35,25 @@ namespace RXBee
 
 class NetworkObserver;
 
+// Capacities of one XBeeNetwork, fixed at construction
+struct NetworkLimits
+{
+    uint16_t rx_buffer_size;        // Bytes, at most 32768
+    uint16_t max_transactions;      // Pending transactions before all are cleared
+    int32_t first_attempt_timeout;  // Service milliseconds for the first attempt
+    int32_t transaction_timeout;    // Service milliseconds per retry
+    int16_t transaction_retry;      // Attempts after the first
+};
+
 class XBeeNetwork : public SerialDataObserver
 {
 public:
     typedef void (*Callback)(XBeeNetwork* source);
     typedef void (*PrintCallback)(const char* message);
+    typedef void (*SubmitHandler)(XBeeNetwork* source, void* context);
+    typedef uint32_t (*Clock)(void);
+    typedef void (*IOSampleHandler)(XBeeNetwork* source, const IOSampleBatch& batch,
+                                    void* context);
 
     
     
@@ -51,15 +79,32 @@ public:
         TX_FAILURE = 0x04
     };
 
+    // Sized by the RXBEE_* macros, the receive buffer is embedded. See
+    // BasicXBeeNetwork for instances sized at compile time.
     XBeeNetwork();
     virtual ~XBeeNetwork();
 
     void Service(uint32_t milliseconds);
 
     Transaction* DiscoverAsync();
+    
+    // Background discovery every interval ms, reported through the
+    // NetworkObserver node callbacks. backoff is NT in 100 ms units
+    // (0 keeps the radio's), larger values spread responses further.
+    void StartDiscovery(uint32_t interval, uint16_t backoff = 0,
+                        uint8_t options = RXBEE_DISCOVERY_NO_RSSI);
+    void StopDiscovery();
 
     void OnStatusChanged(Callback callback);
     
+    // Called whenever a transaction chain is pended, from the pending
+    // thread. Used by event driven drivers to wake the Service thread.
+    void OnSubmit(SubmitHandler handler, void* context);
+    
+    // Milliseconds until Service needs to run again without new input:
+    // 0 when work is ready, -1 when only received data can make progress.
+    int32_t GetNextTimeout();
+    
     ModemStatus GetStatus();
     
     uint16_t GetNetworkID() const;
@@ -68,14 +113,43 @@ public:
     
     ApiMode GetApiMode();
     
+    // Framing used on the serial line, must match the radio's AP setting.
+    // Call before the first Service or from the Service thread. Builds
+    // with RXBEE_FIXED_API_MODE keep that mode.
+    void SetApiMode(ApiMode mode);
+    
+    // Thread safe when built with RXBEE_THREADED, the transaction is
+    // handed to the Service thread once pended.
     Transaction* BeginTransaction(Address addr);
     Transaction* BeginTransaction();
+    
+    // Addresses a node by identifier. Known names cost a directory lookup,
+    // otherwise one FN lookup per name is sent and the transaction waits
+    // for it, failing with INVALID_DESTINATION if nobody answers.
+    // Service thread only.
+    Transaction* BeginTransaction(const char* node_identifier);
     Transaction* BeginBroadcastTransaction();
     
+#if RXBEE_HAS_COROUTINES
+    // ATResult<NP_Rsp> np = co_await net.ReadAsync<XBeeATCommand::NP>();
+    template<XBeeATCommand C>
+    ATReadAwaiter<C> ReadAsync(Address addr = RXBEE_LOCAL_ADDRESS)
+    {
+        Transaction* t = BeginTransaction(addr);
+        t->ReadParameter(Response::ATCommand::Accessor<C>::Name());
+        return ATReadAwaiter<C>(t);
+    }
+#endif
+    
     uint64_t GetTotalTransactions() const;
     
+    // Sum of the milliseconds passed to Service
+    uint32_t GetUptime() const;
+    
     SerialDataSubject* GetSerialDataSubject();
        
+    // May be called from a dedicated reader thread when built with
+    // RXBEE_THREADED, all other members belong to the Service thread.
     void OnNext(const std::vector<uint8_t>& data);
     void OnNext(const uint8_t* data, const uint16_t len);
     void OnComplete();
@@ -87,17 +161,185 @@ public:
     
     void Print(const char* msg);
     
+    // Records a log message, Service thread only. Use the RXBEE_LOG_*
+    // macros so messages below RXBEE_LOG_LEVEL are compiled out.
+    void Log(LogID id, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0);
+    
+    // Formats up to max recorded messages and passes them to the print
+    // handler. Call from an idle loop or a low priority thread, only one
+    // thread may read the log.
+    uint16_t DrainLog(uint16_t max);
+    
+    // Oldest raw log record, e.g. to store for an offline decoder.
+    // Messages read here are not printed.
+    bool ReadLog(LogRecord& record);
+    
+    // Messages lost while the log was full
+    uint32_t GetLogDropped() const;
+    
     uint16_t GetMaxPacketPayloadBytes() const;
+    
+    // Small messages to the same destination share one RF packet, sent
+    // once full or delay_ms after the first message. 0 sends every
+    // message on its own. Service thread only.
+    void SetCoalescing(uint32_t delay_ms);
+    
+    void SendMessage(Address dest, const uint8_t* data, uint16_t n);
+    
+    void FlushMessages();
+    
+    // Sends one packet with frame ID 0: the radio reports no status and no
+    // transaction is used, so beacons and floods never wait for or occupy
+    // the pending table. False when data does not fit one packet.
+    // Service thread only.
+    bool SendDatagram(Address dest, const uint8_t* data, uint16_t n,
+                      uint8_t radius = XBEE_TX_RADIUS_MAX_HOPS,
+                      uint8_t options = XBEE_TX_DELIVERY_DIGIMESH);
+    
+    bool Broadcast(const uint8_t* data, uint16_t n,
+                   uint8_t radius = XBEE_TX_RADIUS_MAX_HOPS,
+                   uint8_t options = XBEE_TX_DELIVERY_DIGIMESH);
+    
+    // Explicit receive frames (0x91, AO = 1) for the endpoint, cluster and
+    // profile go to handler instead of OnSerialDataReceived. Replaces an
+    // earlier registration, false when RXBEE_ENDPOINT_TABLE_SIZE is used up.
+    // Service thread only.
+    bool RegisterEndpoint(uint8_t endpoint, uint16_t cluster, uint16_t profile,
+                          EndpointTable::Handler handler, void* context);
+    
+    bool UnregisterEndpoint(uint8_t endpoint, uint16_t cluster, uint16_t profile);
+    
+    // IO samples (0x92, remote IR sampling) received during a Service call
+    // are handed over in one batch at its end, or sooner once
+    // RXBEE_IO_BATCH_SIZE samples are waiting. Without a handler samples
+    // are dropped. Service thread only.
+    void OnIOSamples(IOSampleHandler handler, void* context);
+    
+    // Delivers enveloped packets from other nodes, coalesced, compressed
+    // or fragmented, as the original messages
+    void SetUnpacking(bool enabled);
+    
+    // Transmit compresses payloads when that makes them smaller. The
+    // receiving nodes must unpack. Thread safe.
+    void SetCompression(bool enabled);
+    
+    PayloadCodec::Stats GetCompressionStats() const;
+    
+    // Nodes learned from ND, FN, node identification and received packets.
+    // Belongs to the Service thread.
+    const NodeDirectory* GetNodeDirectory() const;
+    
+    // Copy of the receive, transmit and transaction counters, see
+    // Metrics::ExportText and Metrics::ExportBinary. Thread safe.
+    void GetMetrics(MetricsSnapshot& snapshot) const;
+    
+#if RXBEE_HISTOGRAMS
+    // Microsecond clock for the latency histograms, e.g. the core timer.
+    // Without one transactions are timed with the Service uptime and
+    // Service durations are not recorded.
+    void SetLatencyClock(Clock clock);
+    
+    // Service thread only
+    const LatencyStats& GetLatencyStats() const;
+    
+    void ResetLatencyStats();
+#endif
+    
+    // Links reported by route information frames, see MeshTopology.
+    // Belongs to the Service thread.
+    const MeshTopology* GetTopology() const;
+    
+    // Records every chunk passed to OnNext and every frame written to the
+    // SerialDataSubject, NULL stops capturing
+    void SetCapture(WireCapture* capture);
+    
+    const NetworkLimits& GetLimits() const;
 
 protected:
     
+    // rx_buffer holds limits.rx_buffer_size bytes. With NULL the embedded
+    // buffer is used if it is large enough, otherwise one is allocated.
+    XBeeNetwork(const NetworkLimits& limits, uint8_t* rx_buffer);
+    
     virtual void DeviceDiscovered(Address address, const std::string& node_id);
     
     virtual void StatusChanged(ModemStatus status);
     
     virtual void SerialDataReceived(const uint64_t source_addr, const std::vector<uint8_t>& data);
     
+    virtual void NodeJoined(const NodeRecord& node);
+    
+    virtual void NodeChanged(const NodeRecord& node);
+    
+    virtual void NodeLeft(const NodeRecord& node);
+    
 private:
+    friend class Transaction;
+    friend class NetworkDiscovery;
+    
+    static void HandleNodeRemoved(const NodeRecord& node, void* context);
+    static void HandleResolveComplete(Transaction* transaction, void* context);
+    
+    enum class ResolveState
+    {
+        LOOKUP,
+        RESOLVED,
+        FAILED
+    };
+    
+    struct Resolution
+    {
+        Address placeholder;
+        Address address;
+        ResolveState state;
+        Transaction* lookup;
+        char node_identifier[XBEE_AT_NI_IDENT_LEN + 1];
+    };
+    
+    // Buffer for the receive ring, see the protected constructor
+    uint8_t* GetRxStorage(uint8_t* rx_buffer, uint16_t size);
+    
+    Address Resolve(const char* node_identifier);
+    
+    void Resolved(const char* node_identifier, Address addr);
+    
+    bool ResolveDestination(Transaction* t);
+    
+    void ReleaseResolutions();
+    
+    // Payload bytes of buffer that fit in one packet after the prefix
+    uint16_t FitPayload(const uint8_t* prefix, uint8_t prefix_n,
+                        const uint8_t* buffer, uint16_t n) const;
+    
+    void FlushIOSamples();
+    
+    // Unpacks when enabled and notifies observers
+    void Deliver(Address source_addr, const std::vector<uint8_t>& data);
+    
+    void UpdateNode(const NodeRecord& node);
+    
+    void ForgetNode(Address addr);
+    
+    void Submit(Transaction* t);
+    
+    void Send(Transaction* t);
+    
+#if RXBEE_HISTOGRAMS
+    uint32_t GetLatencyTime() const;
+    
+    void RecordLatency(const Transaction* t);
+#endif
+    
+    // Serializes the frame to the radio and counts it
+    void WriteFrame(const Frame& f);
+    
+    void SendBurst(Transaction* t);
+    
+#if RXBEE_THREADED
+    void AdoptSubmissions();
+    
+    SubmissionQueue submissions;
+#endif
     
     ModemStatus network_status;
     
@@ -105,15 +347,44 @@ private:
     
     uint8_t frame_count;
     uint32_t frame_count_rollover;
+    uint32_t uptime;
+    uint32_t directory_aged;
     
     std::vector<Transaction*> pending;
         
     std::vector<NetworkObserver*> subscribers;
     
+    NodeDirectory directory;
+    MeshTopology topology;
+    NetworkDiscovery discovery;
+    MessageCoalescer coalescer;
+    PayloadCodec codec;
+    bool unpacking;
+    EndpointTable endpoints;
+    
+    IOSampleBatch io_batch;
+    IOSampleHandler io_handler;
+    void* io_context;
+    
+    std::vector<Resolution> resolutions;
+    uint32_t resolution_count;
+    
+    const NetworkLimits limits;
+#if !(RXBEE_MIRRORED_RING && defined(__linux__))
     uint8_t rx_buff[RXBEE_RX_BUFFER_SIZE];
+#endif
+    SpscRing rx_ring;
+    Shared<bool> rx_overrun;
+    
+    Metrics metrics;
+    Shared<WireCapture*> capture;
+    LogRing log;
+    
+#if RXBEE_HISTOGRAMS
+    LatencyStats latency;
+    Clock latency_clock;
+#endif
     
-    uint16_t rx_buff_head_index;
-    uint16_t rx_buff_tail_index;
     uint16_t tx_buff_index;
     
     SerialDataSubject subject;
@@ -121,14 +392,82 @@ private:
     Callback disc_comp_cb;
     Callback status_changed_cb;
     PrintCallback print_handler;
+    SubmitHandler submit_handler;
+    void* submit_context;
     
     Address local_addr;
-    ApiMode api_mode;
+    Shared<ApiMode> api_mode;
     char node_identifier[XBEE_AT_NI_IDENT_LEN];
     uint8_t preamble_id;
     uint16_t network_id;
     
-    uint16_t max_packet_payload_bytes;
+    Shared<uint16_t> max_packet_payload_bytes;
+};
+
+// Default capacities. A configuration for BasicXBeeNetwork declares the
+// same constants, e.g. a gateway radio
+//
+//     struct GatewayConfig : DefaultNetworkConfig
+//     {
+//         static const uint16_t RX_BUFFER_SIZE = 8192;
+//         static const uint16_t MAX_TRANSACTIONS = 200;
+//     };
+struct DefaultNetworkConfig
+{
+    static const uint16_t RX_BUFFER_SIZE = RXBEE_RX_BUFFER_SIZE;
+    static const uint16_t MAX_TRANSACTIONS = RXBEE_MAX_TRANSACTIONS;
+    static const int32_t FIRST_ATTEMPT_TIMEOUT = RXBEE_FIRST_ATTEMPT_TIMEOUT;
+    static const int32_t TRANSACTION_TIMEOUT = RXBEE_TRANSACTION_TIMEOUT;
+    static const int16_t TRANSACTION_RETRY = RXBEE_TRANSACTION_RETRY;
+};
+
+// Receive buffer of a BasicXBeeNetwork, none when XBeeNetwork's own
+// buffer is used
+template<uint16_t N>
+struct RxStorage
+{
+    uint8_t* Get() { return bytes; }
+    uint8_t bytes[N];
+};
+
+template<>
+struct RxStorage<0>
+{
+    uint8_t* Get() { return NULL; }
+};
+
+// XBeeNetwork with the capacities taken from Config, so no buffer is
+// allocated. Receive buffers up to RXBEE_RX_BUFFER_SIZE use XBeeNetwork's
+// own, larger ones are embedded here. A mirrored ring maps its buffer
+// instead. Usable wherever an XBeeNetwork is.
+template<typename Config = DefaultNetworkConfig>
+class BasicXBeeNetwork : public XBeeNetwork
+{
+public:
+    static_assert((Config::RX_BUFFER_SIZE >= 2) && (Config::RX_BUFFER_SIZE <= 32768),
+                  "RX_BUFFER_SIZE must be between 2 and 32768");
+    static_assert(Config::MAX_TRANSACTIONS > 0, "MAX_TRANSACTIONS must not be 0");
+
+    BasicXBeeNetwork()
+        : XBeeNetwork(NetworkLimits{ Config::RX_BUFFER_SIZE, Config::MAX_TRANSACTIONS,
+                                     Config::FIRST_ATTEMPT_TIMEOUT, Config::TRANSACTION_TIMEOUT,
+                                     Config::TRANSACTION_RETRY },
+                      rx_storage.Get())
+    {
+        
+    }
+
+private:
+#if RXBEE_MIRRORED_RING && defined(__linux__)
+    // The ring maps its own pages, and only allocates if that fails
+    static const uint16_t STORAGE_SIZE = 0;
+#else
+    static const uint16_t STORAGE_SIZE =
+        (Config::RX_BUFFER_SIZE > RXBEE_RX_BUFFER_SIZE) ? Config::RX_BUFFER_SIZE : 0;
+#endif
+
+    // Only addressed until the base is constructed, written by the ring
+    RxStorage<STORAGE_SIZE> rx_storage;
 };
 
 } // namespace XBee
@@ -0,0 +1,216 @@
+
+#include <string>
+
+#include "NetworkDiscovery.h"
+#include "Network.h"
+#include "Command.h"
+
+namespace RXBee
+{
+
+NetworkDiscovery::NetworkDiscovery(XBeeNetwork* network)
+    : net(network), interval(0), backoff(0), options(0), running(false),
+      busy(false), configured(false), configuring(false), swept(false),
+      sweep_start(0), last_sweep_start(0), next_sweep(0),
+      lookup_addr(RXBEE_LOCAL_ADDRESS)
+{
+
+}
+
+void NetworkDiscovery::Start(uint32_t sweep_interval, uint16_t nt, uint8_t no)
+{
+    if ((nt != 0) && (nt < RXBEE_DISCOVERY_NT_MIN))
+    {
+        nt = RXBEE_DISCOVERY_NT_MIN;
+    }
+    else if (nt > RXBEE_DISCOVERY_NT_MAX)
+    {
+        nt = RXBEE_DISCOVERY_NT_MAX;
+    }
+
+    interval = sweep_interval;
+    backoff = nt;
+    options = no;
+    configured = false;
+    configuring = false;
+    swept = false;
+    running = true;
+
+    // First sweep on the next Service call
+    next_sweep = net->GetUptime();
+}
+
+void NetworkDiscovery::Stop()
+{
+    // A sweep in flight still completes, no new ones start
+    running = false;
+    misses.clear();
+}
+
+bool NetworkDiscovery::IsRunning() const
+{
+    return running;
+}
+
+bool NetworkDiscovery::IsBusy() const
+{
+    return busy;
+}
+
+void NetworkDiscovery::Service(uint32_t now)
+{
+    if (running && !busy && (static_cast<int32_t>(now - next_sweep) >= 0))
+    {
+        Sweep(now);
+    }
+}
+
+int32_t NetworkDiscovery::GetNextTimeout(uint32_t now) const
+{
+    int32_t timeout = -1;
+
+    if (running && !busy)
+    {
+        int32_t remaining = static_cast<int32_t>(next_sweep - now);
+        timeout = (remaining > 0) ? remaining : 0;
+    }
+
+    return timeout;
+}
+
+int32_t NetworkDiscovery::GetWindow() const
+{
+    // Responders wait a random part of NT before answering
+    int32_t window = RXBEE_DISCOVERY_TIMEOUT;
+    if (backoff != 0)
+    {
+        window = static_cast<int32_t>(backoff) * 100 + RXBEE_DISCOVERY_MARGIN;
+    }
+    return window;
+}
+
+void NetworkDiscovery::Sweep(uint32_t now)
+{
+    Transaction* t = net->BeginTransaction();
+
+    if (!configured)
+    {
+        // NT and NO only need writing once, ND responses use them
+        if (backoff != 0)
+        {
+            t = t->WriteParameter(XBEE_CMD_NT, backoff);
+        }
+        t = t->WriteParameter(XBEE_CMD_NO, options);
+    }
+    configuring = !configured;
+
+    t = t->NetworkDiscover();
+    t->Collect(GetWindow(), NULL, NULL);
+    t->OnComplete(HandleSweepComplete, this);
+
+    busy = true;
+    sweep_start = now;
+    next_sweep = now + interval;
+    misses.clear();
+
+    t->Pend();
+}
+
+void NetworkDiscovery::Lookup()
+{
+    const NodeDirectory* directory = net->GetNodeDirectory();
+    Transaction* t = NULL;
+
+    while ((t == NULL) && !misses.empty())
+    {
+        lookup_addr = misses.back();
+        misses.pop_back();
+
+        const NodeRecord* node = directory->Find(lookup_addr);
+        if ((node == NULL) || (static_cast<int32_t>(node->last_seen - sweep_start) >= 0))
+        {
+            // Gone already, or heard from since the sweep started
+        }
+        else if (node->node_identifier[0] == '\0')
+        {
+            // No identifier to look up, left to the next sweep
+        }
+        else
+        {
+            t = net->BeginTransaction()->WriteParameter(XBEE_CMD_FN, std::string(node->node_identifier));
+            t->Collect(GetWindow(), NULL, NULL);
+            t->OnComplete(HandleLookupComplete, this);
+            t->Pend();
+        }
+    }
+
+    if (t == NULL)
+    {
+        busy = false;
+    }
+}
+
+void NetworkDiscovery::HandleSweepComplete(Transaction* transaction, void* context)
+{
+    NetworkDiscovery* discovery = static_cast<NetworkDiscovery*>(context);
+
+    if (discovery != NULL)
+    {
+        const NodeDirectory* directory = discovery->net->GetNodeDirectory();
+        const NodeRecord* node;
+        uint16_t cursor = 0;
+        std::vector<Address> left;
+        bool succeeded = (transaction->GetError() == Transaction::Error::NONE);
+
+        if (discovery->configuring && succeeded)
+        {
+            discovery->configured = true;
+        }
+        discovery->configuring = false;
+
+        if (discovery->running && succeeded)
+        {
+            // Nodes neither answering the sweep nor heard from otherwise
+            while ((node = directory->Next(cursor)) != NULL)
+            {
+                if (static_cast<int32_t>(node->last_seen - discovery->sweep_start) >= 0)
+                {
+                    // Answered or heard from
+                }
+                else if (discovery->swept &&
+                         (static_cast<int32_t>(node->last_seen - discovery->last_sweep_start) < 0))
+                {
+                    // Missed the previous sweep as well
+                    left.push_back(node->address);
+                }
+                else if (discovery->misses.size() < RXBEE_DISCOVERY_MAX_LOOKUPS)
+                {
+                    discovery->misses.push_back(node->address);
+                }
+            }
+
+            discovery->last_sweep_start = discovery->sweep_start;
+            discovery->swept = true;
+        }
+
+        for (uint16_t i = 0; i < left.size(); ++i)
+        {
+            discovery->net->ForgetNode(left[i]);
+        }
+
+        discovery->Lookup();
+    }
+}
+
+void NetworkDiscovery::HandleLookupComplete(Transaction*, void* context)
+{
+    NetworkDiscovery* discovery = static_cast<NetworkDiscovery*>(context);
+
+    if (discovery != NULL)
+    {
+        // An answer refreshed the node, silence waits for the next sweep
+        discovery->Lookup();
+    }
+}
+
+} // namespace RXBee
@@ -0,0 +1,82 @@
+#ifndef RXBEE_NETWORK_DISCOVERY_H
+#define RXBEE_NETWORK_DISCOVERY_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "Types.h"
+#include "Transaction.h"
+
+#ifndef RXBEE_DISCOVERY_MARGIN
+    #define RXBEE_DISCOVERY_MARGIN      (1000)  // Milliseconds past NT before a sweep ends
+#endif
+
+#ifndef RXBEE_DISCOVERY_MAX_LOOKUPS
+    #define RXBEE_DISCOVERY_MAX_LOOKUPS (8)     // FN confirmations per sweep
+#endif
+
+#define RXBEE_DISCOVERY_NT_MIN          (0x20)  // NT range, 100 ms units
+#define RXBEE_DISCOVERY_NT_MAX          (0x2EE)
+#define RXBEE_DISCOVERY_NO_RSSI         (0x04)  // NO: append last hop RSSI
+
+namespace RXBee
+{
+
+class XBeeNetwork;
+
+// Keeps the node directory fresh in the background. Every interval the
+// local radio runs one ND sweep whose responses are spread over the NT
+// back-off. Nodes the sweep missed, and that no other traffic refreshed,
+// are looked up one at a time with a targeted FN by identifier, which
+// confirms neighbours early. FN only reaches neighbours, so a node is
+// reported as left once it misses two consecutive sweeps without being
+// heard from in between. Joins and changes are reported as the responses
+// arrive, see NetworkObserver.
+class NetworkDiscovery
+{
+public:
+    NetworkDiscovery(XBeeNetwork* network);
+
+    // backoff is written to NT (100 ms units), 0 keeps the radio's value
+    void Start(uint32_t interval, uint16_t backoff, uint8_t options);
+
+    void Stop();
+
+    bool IsRunning() const;
+
+    // True from the start of a sweep until its lookups are done
+    bool IsBusy() const;
+
+    // Called from XBeeNetwork::Service
+    void Service(uint32_t now);
+
+    // Milliseconds until the next sweep is due, -1 when stopped or busy
+    int32_t GetNextTimeout(uint32_t now) const;
+
+private:
+    static void HandleSweepComplete(Transaction* transaction, void* context);
+    static void HandleLookupComplete(Transaction* transaction, void* context);
+
+    int32_t GetWindow() const;
+    void Sweep(uint32_t now);
+    void Lookup();
+
+    XBeeNetwork* net;
+    uint32_t interval;
+    uint16_t backoff;
+    uint8_t options;
+    bool running;
+    bool busy;
+    bool configured;
+    bool configuring;       // The sweep in flight writes NT and NO
+    bool swept;             // last_sweep_start is valid
+    uint32_t sweep_start;
+    uint32_t last_sweep_start;  // Start of the last successful sweep
+    uint32_t next_sweep;
+    std::vector<Address> misses;
+    Address lookup_addr;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_NETWORK_DISCOVERY_H
@@ -1,7 +1,7 @@
 
 
 #ifndef RXBEE_NETWORK_OBSERVER_H    /* Guard against multiple inclusion */
-#define RXBEE_NETOWRK_OBSERVER_H
+#define RXBEE_NETWORK_OBSERVER_H
 
 
 
@@ -24,6 +24,13 @@ public:
     virtual void OnDeviceDiscovered(XBeeNetwork* network, const Address address, const std::string& node_id) = 0;
     
     virtual void OnStatusChanged(XBeeNetwork* network, ModemStatus prev, ModemStatus current) = 0;
+    
+    // Node directory deltas, see XBeeNetwork::StartDiscovery
+    virtual void OnNodeJoined(XBeeNetwork*, const NodeRecord&) { }
+    
+    virtual void OnNodeChanged(XBeeNetwork*, const NodeRecord&) { }
+    
+    virtual void OnNodeLeft(XBeeNetwork*, const NodeRecord&) { }
 };
 
 } // namespace RXBee
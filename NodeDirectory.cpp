@@ -0,0 +1,341 @@
+
+#include <string.h>
+
+#include "NodeDirectory.h"
+
+#define RXBEE_NODE_EMPTY        (RXBEE_LOCAL_ADDRESS)   // Never a remote node
+
+namespace RXBee
+{
+
+NodeDirectory::NodeDirectory() : on_removed_handler(NULL), on_removed_context(NULL)
+{
+    Clear();
+}
+
+void NodeDirectory::OnRemoved(NodeDirectory::RemoveHandler handler, void* context)
+{
+    on_removed_handler = handler;
+    on_removed_context = context;
+}
+
+void NodeDirectory::Clear()
+{
+    for (uint16_t i = 0; i < RXBEE_NODE_DIRECTORY_SIZE; ++i)
+    {
+        nodes[i].address = RXBEE_NODE_EMPTY;
+        names[i] = RXBEE_NODE_EMPTY;
+    }
+    count = 0;
+}
+
+uint16_t NodeDirectory::Home(const char* node_identifier)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (uint16_t i = 0; (i < XBEE_AT_NI_IDENT_LEN) && (node_identifier[i] != '\0'); ++i)
+    {
+        hash ^= static_cast<uint8_t>(node_identifier[i]);
+        hash *= 16777619UL;
+    }
+    return Table::Slot(hash ^ (hash >> 16));
+}
+
+uint16_t NodeDirectory::Probe(Address addr) const
+{
+    return Table::Probe(nodes, &NodeRecord::address, addr, RXBEE_NODE_EMPTY);
+}
+
+const NodeRecord* NodeDirectory::Find(Address addr) const
+{
+    const NodeRecord* node = NULL;
+
+    if (addr != RXBEE_NODE_EMPTY)
+    {
+        uint16_t i = Probe(addr);
+        if (nodes[i].address == addr)
+        {
+            node = &nodes[i];
+        }
+    }
+
+    return node;
+}
+
+const NodeRecord* NodeDirectory::Find(const char* node_identifier) const
+{
+    const NodeRecord* node = NULL;
+    uint16_t i = Home(node_identifier);
+
+    while ((names[i] != RXBEE_NODE_EMPTY) && (node == NULL))
+    {
+        const NodeRecord* n = Find(names[i]);
+        if ((n != NULL) &&
+            (strncmp(n->node_identifier, node_identifier, XBEE_AT_NI_IDENT_LEN) == 0))
+        {
+            node = n;
+        }
+        i = Table::Next(i);
+    }
+
+    return node;
+}
+
+NodeDirectory::Change NodeDirectory::Update(const NodeRecord& node)
+{
+    Change change = Change::REFRESHED;
+
+    if (node.address != RXBEE_NODE_EMPTY)
+    {
+        NodeRecord* n = &nodes[Probe(node.address)];
+        if (n->address != node.address)
+        {
+            n = Insert(node.address, node.last_seen);
+            change = Change::INSERTED;
+        }
+
+        if (strncmp(n->node_identifier, node.node_identifier, XBEE_AT_NI_IDENT_LEN) != 0)
+        {
+            UnindexName(n->address, n->node_identifier);
+            strncpy(n->node_identifier, node.node_identifier, XBEE_AT_NI_IDENT_LEN);
+            n->node_identifier[XBEE_AT_NI_IDENT_LEN] = '\0';
+            IndexName(n->address, n->node_identifier);
+
+            if (change == Change::REFRESHED)
+            {
+                change = Change::CHANGED;
+            }
+        }
+
+        if ((change == Change::REFRESHED) &&
+            ((n->device_type != node.device_type) ||
+             (n->profile_id != node.profile_id) ||
+             (n->mfr_id != node.mfr_id) ||
+             (n->digi_device_type != node.digi_device_type)))
+        {
+            change = Change::CHANGED;
+        }
+
+        n->device_type = node.device_type;
+        n->profile_id = node.profile_id;
+        n->mfr_id = node.mfr_id;
+        n->digi_device_type = node.digi_device_type;
+        n->last_seen = node.last_seen;
+        if (node.rssi != 0)
+        {
+            n->rssi = node.rssi;
+        }
+    }
+
+    return change;
+}
+
+NodeDirectory::Change NodeDirectory::Touch(Address addr, uint32_t now)
+{
+    Change change = Change::REFRESHED;
+
+    if (addr != RXBEE_NODE_EMPTY)
+    {
+        uint16_t i = Probe(addr);
+        if (nodes[i].address == addr)
+        {
+            nodes[i].last_seen = now;
+        }
+        else
+        {
+            Insert(addr, now);
+            change = Change::INSERTED;
+        }
+    }
+
+    return change;
+}
+
+NodeRecord* NodeDirectory::Insert(Address addr, uint32_t now)
+{
+    if (count >= Table::MAX_COUNT)
+    {
+        Evict(now);
+    }
+
+    uint16_t i = Probe(addr);
+    NodeRecord* n = &nodes[i];
+
+    n->address = addr;
+    n->node_identifier[0] = '\0';
+    n->device_type = RXBEE_NODE_DEVICE_TYPE_UNKNOWN;
+    n->profile_id = 0;
+    n->mfr_id = 0;
+    n->digi_device_type = 0;
+    n->rssi = 0;
+    n->last_seen = now;
+    count++;
+
+    return n;
+}
+
+void NodeDirectory::Evict(uint32_t now)
+{
+    uint16_t oldest = RXBEE_NODE_DIRECTORY_SIZE;
+    uint32_t oldest_age = 0;
+
+    for (uint16_t i = 0; i < RXBEE_NODE_DIRECTORY_SIZE; ++i)
+    {
+        if ((nodes[i].address != RXBEE_NODE_EMPTY) &&
+            ((oldest == RXBEE_NODE_DIRECTORY_SIZE) || (now - nodes[i].last_seen > oldest_age)))
+        {
+            oldest = i;
+            oldest_age = now - nodes[i].last_seen;
+        }
+    }
+
+    if (oldest < RXBEE_NODE_DIRECTORY_SIZE)
+    {
+        if (on_removed_handler != NULL)
+        {
+            on_removed_handler(nodes[oldest], on_removed_context);
+        }
+        Erase(oldest);
+    }
+}
+
+bool NodeDirectory::Remove(Address addr)
+{
+    bool removed = false;
+
+    if (addr != RXBEE_NODE_EMPTY)
+    {
+        uint16_t i = Probe(addr);
+        if (nodes[i].address == addr)
+        {
+            Erase(i);
+            removed = true;
+        }
+    }
+
+    return removed;
+}
+
+uint16_t NodeDirectory::Expire(uint32_t now, uint32_t max_age)
+{
+    uint16_t removed = 0;
+    uint16_t i = 0;
+
+    while ((max_age > 0) && (i < RXBEE_NODE_DIRECTORY_SIZE))
+    {
+        if ((nodes[i].address != RXBEE_NODE_EMPTY) &&
+            (now - nodes[i].last_seen >= max_age))
+        {
+            if (on_removed_handler != NULL)
+            {
+                on_removed_handler(nodes[i], on_removed_context);
+            }
+            
+            // A later node may shift into this slot, check it again
+            Erase(i);
+            removed++;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    return removed;
+}
+
+void NodeDirectory::Erase(uint16_t slot)
+{
+    UnindexName(nodes[slot].address, nodes[slot].node_identifier);
+    Table::Erase(nodes, &NodeRecord::address, slot, RXBEE_NODE_EMPTY);
+    count--;
+}
+
+void NodeDirectory::IndexName(Address addr, const char* node_identifier)
+{
+    if (node_identifier[0] != '\0')
+    {
+        uint16_t i = Home(node_identifier);
+        while (names[i] != RXBEE_NODE_EMPTY)
+        {
+            i = Table::Next(i);
+        }
+        names[i] = addr;
+    }
+}
+
+void NodeDirectory::UnindexName(Address addr, const char* node_identifier)
+{
+    if (node_identifier[0] != '\0')
+    {
+        uint16_t hole = Home(node_identifier);
+        while ((names[hole] != RXBEE_NODE_EMPTY) && (names[hole] != addr))
+        {
+            hole = Table::Next(hole);
+        }
+
+        if (names[hole] == addr)
+        {
+            // Backward shift as in OpenAddressing::Erase, the home slot of
+            // a name comes from its node's identifier
+            uint16_t j = Table::Next(hole);
+            while (names[j] != RXBEE_NODE_EMPTY)
+            {
+                const NodeRecord* n = Find(names[j]);
+                uint16_t home = (n != NULL) ? Home(n->node_identifier) : j;
+                if (Table::Distance(home, j) >= Table::Distance(hole, j))
+                {
+                    names[hole] = names[j];
+                    hole = j;
+                }
+                j = Table::Next(j);
+            }
+
+            names[hole] = RXBEE_NODE_EMPTY;
+        }
+    }
+}
+
+uint16_t NodeDirectory::GetCount() const
+{
+    return count;
+}
+
+uint16_t NodeDirectory::GetMaxCount() const
+{
+    return Table::MAX_COUNT;
+}
+
+const NodeRecord* NodeDirectory::Next(uint16_t& cursor) const
+{
+    const NodeRecord* node = NULL;
+
+    while ((cursor < RXBEE_NODE_DIRECTORY_SIZE) && (node == NULL))
+    {
+        if (nodes[cursor].address != RXBEE_NODE_EMPTY)
+        {
+            node = &nodes[cursor];
+        }
+        cursor++;
+    }
+
+    return node;
+}
+
+uint16_t NodeDirectory::Snapshot(std::vector<NodeRecord>& snapshot) const
+{
+    snapshot.clear();
+    snapshot.reserve(count);
+
+    for (uint16_t i = 0; i < RXBEE_NODE_DIRECTORY_SIZE; ++i)
+    {
+        if (nodes[i].address != RXBEE_NODE_EMPTY)
+        {
+            snapshot.push_back(nodes[i]);
+        }
+    }
+
+    return snapshot.size();
+}
+
+} // namespace RXBee
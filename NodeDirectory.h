@@ -0,0 +1,108 @@
+#ifndef RXBEE_NODE_DIRECTORY_H
+#define RXBEE_NODE_DIRECTORY_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "Types.h"
+#include "SpecificResponses.h"
+#include "OpenAddressing.h"
+
+#ifndef RXBEE_NODE_DIRECTORY_SIZE
+    #define RXBEE_NODE_DIRECTORY_SIZE   (64)    // Slots, power of two
+#endif
+
+#ifndef RXBEE_NODE_MAX_AGE
+    #define RXBEE_NODE_MAX_AGE  (900000)    // Milliseconds unseen before removal, 0 never
+#endif
+
+namespace RXBee
+{
+
+#define RXBEE_NODE_DEVICE_TYPE_UNKNOWN  (0xFF)
+
+struct NodeRecord
+{
+    Address address;
+    char node_identifier[XBEE_AT_NI_IDENT_LEN + 1];
+    uint8_t device_type;
+    uint16_t profile_id;
+    uint16_t mfr_id;
+    uint32_t digi_device_type;
+    uint8_t rssi;               // Last hop RSSI, 0 when unknown
+    uint32_t last_seen;         // Network uptime in milliseconds
+};
+
+// Known nodes keyed by address, with a reverse index by node identifier.
+// Both are open addressed tables, see OpenAddressing. The least recently
+// seen node is replaced when the directory is full.
+class NodeDirectory
+{
+public:
+    enum class Change
+    {
+        INSERTED,
+        CHANGED,        // Identifier, device type or ids differ
+        REFRESHED       // Only last seen time and RSSI updated
+    };
+
+    typedef void (*RemoveHandler)(const NodeRecord& node, void* context);
+
+    NodeDirectory();
+
+    // Full record from ND, FN or a node identification indicator
+    Change Update(const NodeRecord& node);
+
+    // Node heard from, e.g. a received packet. Unknown nodes are added
+    // without an identifier.
+    Change Touch(Address addr, uint32_t now);
+
+    bool Remove(Address addr);
+
+    void Clear();
+
+    // Called with each node the directory drops on its own, expired or
+    // replaced when full, just before it is removed
+    void OnRemoved(RemoveHandler handler, void* context);
+
+    // Removes nodes not seen for max_age milliseconds, returns the count
+    uint16_t Expire(uint32_t now, uint32_t max_age);
+
+    const NodeRecord* Find(Address addr) const;
+
+    // First node with the identifier, NULL if unknown
+    const NodeRecord* Find(const char* node_identifier) const;
+
+    uint16_t GetCount() const;
+
+    uint16_t GetMaxCount() const;
+
+    // for (uint16_t c = 0; (n = dir.Next(c)) != NULL;) visits every node.
+    // Not valid across modifications.
+    const NodeRecord* Next(uint16_t& cursor) const;
+
+    // Copies every node, safe to keep while the directory changes
+    uint16_t Snapshot(std::vector<NodeRecord>& nodes) const;
+
+private:
+    typedef OpenAddressing<Address, RXBEE_NODE_DIRECTORY_SIZE> Table;
+
+    static uint16_t Home(const char* node_identifier);
+
+    uint16_t Probe(Address addr) const;
+    void Erase(uint16_t slot);
+    void IndexName(Address addr, const char* node_identifier);
+    void UnindexName(Address addr, const char* node_identifier);
+    void Evict(uint32_t now);
+    NodeRecord* Insert(Address addr, uint32_t now);
+
+    NodeRecord nodes[RXBEE_NODE_DIRECTORY_SIZE];
+    Address names[RXBEE_NODE_DIRECTORY_SIZE];
+    uint16_t count;
+    RemoveHandler on_removed_handler;
+    void* on_removed_context;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_NODE_DIRECTORY_H
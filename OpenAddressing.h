@@ -0,0 +1,89 @@
+#ifndef RXBEE_OPEN_ADDRESSING_H
+#define RXBEE_OPEN_ADDRESSING_H
+
+#include <stdint.h>
+
+namespace RXBee
+{
+
+// Slot arithmetic of the library's fixed size hash tables (NodeDirectory,
+// EndpointTable, IOSampleHistory): open addressing over an array of Size
+// entries with linear probing and backward shift deletion, so lookups
+// never allocate and there are no tombstones. Size is a power of two and
+// a table holds at most MAX_COUNT entries, which keeps probe runs short
+// and guarantees an empty slot. Entries are found by their key field, an
+// empty slot holds a key no entry uses.
+template<typename Key, uint16_t Size>
+class OpenAddressing
+{
+public:
+    static_assert((Size > 0) && ((Size & (Size - 1)) == 0), "Size must be a power of two");
+
+    static const uint16_t MAX_COUNT = Size * 3 / 4;
+
+    // Fibonacci hashing, serial numbers only differ in the low bytes
+    static uint16_t Home(Key key)
+    {
+        return static_cast<uint16_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> 48) &
+               MASK;
+    }
+
+    // Slot of a hash computed by the table, e.g. of a string key
+    static uint16_t Slot(uint32_t hash)
+    {
+        return static_cast<uint16_t>(hash) & MASK;
+    }
+
+    static uint16_t Next(uint16_t slot)
+    {
+        return (slot + 1) & MASK;
+    }
+
+    // Probe steps from slot from forward to slot to
+    static uint16_t Distance(uint16_t from, uint16_t to)
+    {
+        return (to - from) & MASK;
+    }
+
+    // Slot of the entry with the key, otherwise the empty slot ending its
+    // probe run
+    template<typename Entry>
+    static uint16_t Probe(const Entry* entries, Key Entry::*field, Key key, Key empty)
+    {
+        uint16_t i = Home(key);
+        while ((entries[i].*field != empty) && (entries[i].*field != key))
+        {
+            i = Next(i);
+        }
+        return i;
+    }
+
+    // Removes the entry at slot. Later entries of the probe run move into
+    // the hole unless that would put them before their home slot. Returns
+    // the slot left empty, only its key is reset.
+    template<typename Entry>
+    static uint16_t Erase(Entry* entries, Key Entry::*field, uint16_t slot, Key empty)
+    {
+        uint16_t hole = slot;
+        uint16_t j = Next(slot);
+        while (entries[j].*field != empty)
+        {
+            if (Distance(Home(entries[j].*field), j) >= Distance(hole, j))
+            {
+                entries[hole] = entries[j];
+                hole = j;
+            }
+            j = Next(j);
+        }
+
+        entries[hole].*field = empty;
+        return hole;
+    }
+
+private:
+    static const uint16_t MASK = Size - 1;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_OPEN_ADDRESSING_H
@@ -0,0 +1,510 @@
+
+#include "PayloadCodec.h"
+
+#define RXBEE_LZSS_MIN_MATCH    (3)
+#define RXBEE_LZSS_MAX_MATCH    (RXBEE_LZSS_MIN_MATCH + 0x0F)
+#define RXBEE_LZSS_MAX_OFFSET   (0x1000)
+
+namespace RXBee
+{
+
+static_assert(RXBEE_LZSS_WINDOW <= RXBEE_LZSS_MAX_OFFSET,
+              "RXBEE_LZSS_WINDOW must fit the 12 bit offset");
+
+PayloadCodec::PayloadCodec() : compressing(false)
+{
+    ResetStats();
+}
+
+void PayloadCodec::SetCompression(bool enabled)
+{
+    compressing = enabled;
+}
+
+bool PayloadCodec::IsCompressing() const
+{
+    return compressing;
+}
+
+bool PayloadCodec::Compress(const uint8_t* data, uint16_t n, std::vector<uint8_t>& packed)
+{
+    bool smaller = false;
+
+    Encode(data, n, packed);
+    if (packed.size() < n)
+    {
+        smaller = true;
+    }
+    else
+    {
+        packed.clear();
+    }
+
+    offered += 1;
+    raw_bytes += n;
+    if (smaller)
+    {
+        compressed += 1;
+        packed_bytes += packed.size();
+    }
+    else
+    {
+        packed_bytes += n;
+    }
+
+    return smaller;
+}
+
+void PayloadCodec::Encode(const uint8_t* data, uint16_t n, std::vector<uint8_t>& out)
+{
+    uint16_t i = 0;
+    uint32_t flag_index = 0;
+    uint8_t bit = 8;
+
+    out.clear();
+    out.reserve(n + n / 8 + 1);
+
+    while (i < n)
+    {
+        if (bit == 8)
+        {
+            flag_index = out.size();
+            out.push_back(0);
+            bit = 0;
+        }
+
+        uint16_t best_len = 0;
+        uint16_t best_offset = 0;
+        uint16_t max_len = ((n - i) < RXBEE_LZSS_MAX_MATCH) ? (n - i) : RXBEE_LZSS_MAX_MATCH;
+        uint16_t start = (i > RXBEE_LZSS_WINDOW) ? (i - RXBEE_LZSS_WINDOW) : 0;
+
+        // Nearest longest match, may overlap the bytes being encoded
+        for (uint16_t j = i; (j > start) && (best_len < max_len);)
+        {
+            --j;
+            uint16_t len = 0;
+            while ((len < max_len) && (data[j + len] == data[i + len]))
+            {
+                ++len;
+            }
+
+            if (len > best_len)
+            {
+                best_len = len;
+                best_offset = i - j;
+            }
+        }
+
+        if (best_len >= RXBEE_LZSS_MIN_MATCH)
+        {
+            out.push_back(static_cast<uint8_t>((best_offset - 1) >> 4));
+            out.push_back(static_cast<uint8_t>((((best_offset - 1) & 0x0F) << 4) |
+                                               (best_len - RXBEE_LZSS_MIN_MATCH)));
+            i += best_len;
+        }
+        else
+        {
+            out[flag_index] |= (1 << bit);
+            out.push_back(data[i]);
+            ++i;
+        }
+        ++bit;
+    }
+}
+
+bool PayloadCodec::Decode(const uint8_t* data, uint16_t n, std::vector<uint8_t>& out)
+{
+    bool valid = true;
+    uint16_t i = 0;
+    uint8_t flags = 0;
+    uint8_t bit = 8;
+
+    out.clear();
+
+    while (valid && (i < n))
+    {
+        if (bit == 8)
+        {
+            flags = data[i++];
+            bit = 0;
+        }
+        else if (flags & (1 << bit))
+        {
+            out.push_back(data[i++]);
+            ++bit;
+        }
+        else if (i + 1 < n)
+        {
+            uint16_t offset = ((data[i] << 4) | (data[i + 1] >> 4)) + 1;
+            uint16_t len = (data[i + 1] & 0x0F) + RXBEE_LZSS_MIN_MATCH;
+            i += 2;
+
+            if ((offset > out.size()) || (out.size() + len > RXBEE_UNPACK_MAX_SIZE))
+            {
+                valid = false;
+            }
+            else
+            {
+                for (uint16_t k = 0; k < len; ++k)
+                {
+                    out.push_back(out[out.size() - offset]);
+                }
+            }
+            ++bit;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (out.size() > RXBEE_UNPACK_MAX_SIZE)
+        {
+            valid = false;
+        }
+    }
+
+    return valid;
+}
+
+bool PayloadCodec::Unpack(Address src, const std::vector<uint8_t>& packet,
+                          std::vector<std::vector<uint8_t> >& messages)
+{
+    bool envelope = false;
+
+    if (!packet.empty() &&
+        ((packet[0] & RXBEE_ENVELOPE_HEADER_MASK) == RXBEE_ENVELOPE_HEADER))
+    {
+        uint8_t flags = packet[0] & ~RXBEE_ENVELOPE_HEADER_MASK;
+        std::vector<uint8_t> body(packet.begin() + 1, packet.end());
+        bool complete = true;
+        envelope = true;
+
+        if (flags & RXBEE_ENVELOPE_FRAGMENT)
+        {
+            std::vector<uint8_t> message;
+            complete = Reassemble(src, body.empty() ? NULL : &body[0], body.size(), message);
+            body.swap(message);
+        }
+
+        if (complete && (flags & RXBEE_ENVELOPE_COMPRESSED))
+        {
+            std::vector<uint8_t> message;
+            if (Decode(body.empty() ? NULL : &body[0], body.size(), message))
+            {
+                expanded++;
+                received_bytes += body.size();
+                expanded_bytes += message.size();
+                body.swap(message);
+            }
+            else
+            {
+                dropped++;
+                complete = false;
+            }
+        }
+
+        if (complete && (flags & RXBEE_ENVELOPE_DELTA))
+        {
+            std::vector<uint8_t> record;
+            complete = Rebuild(src, body, record);
+            body.swap(record);
+        }
+
+        if (complete && (flags & RXBEE_ENVELOPE_COALESCED))
+        {
+            // Length prefixed messages, all or nothing
+            uint16_t first = messages.size();
+            uint16_t i = 0;
+
+            while ((i < body.size()) && (i + 1u + body[i] <= body.size()))
+            {
+                messages.push_back(std::vector<uint8_t>(body.begin() + i + 1,
+                                                        body.begin() + i + 1 + body[i]));
+                i += 1 + body[i];
+            }
+
+            if ((i != body.size()) || (messages.size() == first))
+            {
+                messages.resize(first);
+                if (flags == RXBEE_ENVELOPE_COALESCED)
+                {
+                    // Not an envelope after all
+                    envelope = false;
+                }
+                else
+                {
+                    dropped++;
+                }
+            }
+        }
+        else if (complete)
+        {
+            messages.push_back(body);
+        }
+    }
+
+    return envelope;
+}
+
+bool PayloadCodec::Reassemble(Address src, const uint8_t* fragment, uint16_t n,
+                              std::vector<uint8_t>& message)
+{
+    bool complete = false;
+    uint16_t r = 0;
+
+    for (; r < reassembly.size(); ++r)
+    {
+        if (reassembly[r].src == src)
+        {
+            break;
+        }
+    }
+
+    if ((n >= 3) && (fragment[0] == 0))
+    {
+        // First fragment, restarts anything left over from the sender
+        if (r >= reassembly.size())
+        {
+            if (reassembly.size() >= RXBEE_REASSEMBLY_SOURCES)
+            {
+                reassembly.erase(reassembly.begin());
+            }
+            reassembly.push_back(Reassembly());
+            r = reassembly.size() - 1;
+        }
+
+        reassembly[r].src = src;
+        reassembly[r].next_index = 1;
+        reassembly[r].length = (fragment[1] << 8) | fragment[2];
+        reassembly[r].data.assign(fragment + 3, fragment + n);
+    }
+    else if ((n >= 1) && (r < reassembly.size()) && (fragment[0] == reassembly[r].next_index))
+    {
+        reassembly[r].next_index++;
+        reassembly[r].data.insert(reassembly[r].data.end(), fragment + 1, fragment + n);
+    }
+    else
+    {
+        // Missed a fragment, wait for the next first one
+        if (r < reassembly.size())
+        {
+            reassembly.erase(reassembly.begin() + r);
+        }
+        r = reassembly.size();
+        dropped++;
+    }
+
+    if (r < reassembly.size())
+    {
+        Reassembly& entry = reassembly[r];
+
+        if ((entry.length > RXBEE_UNPACK_MAX_SIZE) || (entry.data.size() > entry.length))
+        {
+            reassembly.erase(reassembly.begin() + r);
+            dropped++;
+        }
+        else if (entry.data.size() == entry.length)
+        {
+            message.swap(entry.data);
+            reassembly.erase(reassembly.begin() + r);
+            complete = true;
+        }
+    }
+
+    return complete;
+}
+
+void PayloadCodec::EncodeDelta(const uint8_t* base, const uint8_t* record, uint16_t n,
+                               std::vector<uint8_t>& out)
+{
+    uint16_t i = 0;
+
+    out.clear();
+
+    while (i < n)
+    {
+        uint16_t same = 0;
+        while ((i + same < n) && (same < 0xFF) && (base[i + same] == record[i + same]))
+        {
+            ++same;
+        }
+
+        if (i + same >= n)
+        {
+            break;
+        }
+
+        // A short unchanged gap costs less inside the run than a new run
+        uint16_t start = i + same;
+        uint16_t end = start;
+        while ((end < n) && (end - start < 0xFF))
+        {
+            if ((base[end] == record[end]) &&
+                ((end + 2 >= n) || ((base[end + 1] == record[end + 1]) && (base[end + 2] == record[end + 2]))))
+            {
+                break;
+            }
+            ++end;
+        }
+
+        out.push_back(static_cast<uint8_t>(same));
+        out.push_back(static_cast<uint8_t>(end - start));
+        for (uint16_t k = start; k < end; ++k)
+        {
+            out.push_back(base[k] ^ record[k]);
+        }
+        i = end;
+    }
+}
+
+bool PayloadCodec::DecodeDelta(const uint8_t* delta, uint16_t n, std::vector<uint8_t>& record)
+{
+    bool valid = true;
+    uint16_t i = 0;
+    uint16_t pos = 0;
+
+    while (valid && (i < n))
+    {
+        if (i + 1 >= n)
+        {
+            valid = false;
+        }
+        else
+        {
+            uint16_t count = delta[i + 1];
+            pos += delta[i];
+            i += 2;
+
+            if ((i + count > n) || (pos + count > record.size()))
+            {
+                valid = false;
+            }
+            else
+            {
+                for (uint16_t k = 0; k < count; ++k)
+                {
+                    record[pos++] ^= delta[i++];
+                }
+            }
+        }
+    }
+
+    return valid;
+}
+
+bool PayloadCodec::Rebuild(Address src, const std::vector<uint8_t>& body, std::vector<uint8_t>& record)
+{
+    bool rebuilt = false;
+    uint16_t s = 0;
+    uint8_t id = (body.size() > 0) ? body[0] : 0;
+    uint8_t sequence = (body.size() > 1) ? body[1] : 0;
+    uint8_t base = (body.size() > 2) ? body[2] : 0;
+
+    for (; s < streams.size(); ++s)
+    {
+        if ((streams[s].src == src) && (streams[s].id == id))
+        {
+            break;
+        }
+    }
+
+    if (body.size() < 3)
+    {
+        dropped++;
+    }
+    else if (base == sequence)
+    {
+        // Keyframe
+        record.assign(body.begin() + 3, body.end());
+        rebuilt = true;
+    }
+    else
+    {
+        bool found = false;
+
+        for (uint16_t h = (s < streams.size()) ? streams[s].history.size() : 0; (h > 0) && !found;)
+        {
+            --h;
+            if (streams[s].history[h].sequence == base)
+            {
+                found = true;
+                record = streams[s].history[h].data;
+                if (DecodeDelta(&body[3], body.size() - 3, record))
+                {
+                    deltas++;
+                    rebuilt = true;
+                }
+                else
+                {
+                    dropped++;
+                }
+            }
+        }
+
+        if (!found)
+        {
+            // Lost the base, the sender resyncs with a keyframe
+            missed_bases++;
+        }
+    }
+
+    if (rebuilt)
+    {
+        if (s >= streams.size())
+        {
+            if (streams.size() >= RXBEE_DELTA_STREAMS)
+            {
+                streams.erase(streams.begin());
+            }
+            Stream stream;
+            stream.src = src;
+            stream.id = id;
+            streams.push_back(stream);
+            s = streams.size() - 1;
+        }
+
+        std::vector<StreamRecord>& history = streams[s].history;
+        if (history.size() >= RXBEE_DELTA_HISTORY)
+        {
+            history.erase(history.begin());
+        }
+        StreamRecord entry;
+        entry.sequence = sequence;
+        entry.data = record;
+        history.push_back(entry);
+    }
+
+    return rebuilt;
+}
+
+PayloadCodec::Stats PayloadCodec::GetStats() const
+{
+    Stats stats;
+    stats.offered = offered;
+    stats.compressed = compressed;
+    stats.raw_bytes = raw_bytes;
+    stats.packed_bytes = packed_bytes;
+    stats.expanded = expanded;
+    stats.received_bytes = received_bytes;
+    stats.expanded_bytes = expanded_bytes;
+    stats.dropped = dropped;
+    stats.deltas = deltas;
+    stats.missed_bases = missed_bases;
+    return stats;
+}
+
+void PayloadCodec::ResetStats()
+{
+    offered = 0;
+    compressed = 0;
+    raw_bytes = 0;
+    packed_bytes = 0;
+    expanded = 0;
+    received_bytes = 0;
+    expanded_bytes = 0;
+    dropped = 0;
+    deltas = 0;
+    missed_bases = 0;
+}
+
+} // namespace RXBee
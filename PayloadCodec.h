@@ -0,0 +1,156 @@
+#ifndef RXBEE_PAYLOAD_CODEC_H
+#define RXBEE_PAYLOAD_CODEC_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "Types.h"
+#include "SpscRing.h"
+
+#ifndef RXBEE_LZSS_WINDOW
+    #define RXBEE_LZSS_WINDOW           (512)   // Match search distance, at most 4096
+#endif
+
+#ifndef RXBEE_UNPACK_MAX_SIZE
+    #define RXBEE_UNPACK_MAX_SIZE       (2048)  // Largest reassembled or expanded message
+#endif
+
+#ifndef RXBEE_REASSEMBLY_SOURCES
+    #define RXBEE_REASSEMBLY_SOURCES    (4)     // Senders reassembled at once
+#endif
+
+#ifndef RXBEE_DELTA_STREAMS
+    #define RXBEE_DELTA_STREAMS         (8)     // Telemetry streams received at once
+#endif
+
+#ifndef RXBEE_DELTA_HISTORY
+    #define RXBEE_DELTA_HISTORY         (4)     // Records kept per stream as delta bases
+#endif
+
+// First payload byte of an enveloped packet, the low nibble holds flags
+#define RXBEE_ENVELOPE_HEADER           (0xA0)
+#define RXBEE_ENVELOPE_HEADER_MASK      (0xF0)
+#define RXBEE_ENVELOPE_COALESCED        (0x01)  // Length prefixed messages follow
+#define RXBEE_ENVELOPE_COMPRESSED       (0x02)  // LZSS, see PayloadCodec::Encode
+#define RXBEE_ENVELOPE_DELTA            (0x04)  // Telemetry stream record
+#define RXBEE_ENVELOPE_FRAGMENT         (0x08)  // Index byte, length on index 0
+#define RXBEE_ENVELOPE_MAX_MESSAGE      (0xFF)  // Largest coalesced message
+#define RXBEE_ENVELOPE_MAX_FRAGMENTS    (0xFF)  // Fragments per message, one index byte
+
+namespace RXBee
+{
+
+// Envelope handling shared by the transmit and receive paths. Messages are
+// compressed before Transaction::Transmit fragments them, fragments carry
+// an index so the receiver can put the message back together:
+//
+//   [0xA0 | flags] [body]
+//   [0xA8 | flags] [0] [length MSB] [length LSB] [body...]
+//   [0xA8 | flags] [1] [...body]
+//
+// Telemetry stream records (see TelemetryStream) are keyframes, the whole
+// record, or deltas against an earlier record of the stream:
+//
+//   [0xA4] [stream id] [sequence] [base sequence] [record or delta]
+//
+// A keyframe has the base sequence equal to its own.
+//
+// Both ends opt in, the sender with SetCompression and the receiver with
+// SetUnpacking. Packets not starting with an envelope header pass through.
+class PayloadCodec
+{
+public:
+    struct Stats
+    {
+        uint32_t offered;           // Messages sent with compression allowed
+        uint32_t compressed;        // Of those, sent compressed
+        uint32_t raw_bytes;         // Bytes offered
+        uint32_t packed_bytes;      // Bytes sent for them
+        uint32_t expanded;          // Compressed messages received
+        uint32_t received_bytes;    // Compressed bytes received
+        uint32_t expanded_bytes;    // After expansion
+        uint32_t dropped;           // Corrupt or incomplete envelopes
+        uint32_t deltas;            // Stream records rebuilt from a delta
+        uint32_t missed_bases;      // Deltas dropped, base record unknown
+    };
+
+    PayloadCodec();
+
+    void SetCompression(bool enabled);
+
+    bool IsCompressing() const;
+
+    // Compresses into packed, false when that would not save anything.
+    // Thread safe, called by Transmit.
+    bool Compress(const uint8_t* data, uint16_t n, std::vector<uint8_t>& packed);
+
+    // Appends the messages carried by an enveloped packet. Returns false
+    // when the packet is not an envelope and should be delivered as is.
+    // A fragment is consumed without adding messages until the last one.
+    bool Unpack(Address src, const std::vector<uint8_t>& packet,
+                std::vector<std::vector<uint8_t> >& messages);
+
+    Stats GetStats() const;
+
+    void ResetStats();
+
+    // LZSS with a 12 bit offset and 4 bit length: a flag byte selects, LSB
+    // first, a literal (1) or a 2 byte match (0) for each of the next 8 items.
+    // Needs no memory beyond the output, suits small packets on a PIC32.
+    static void Encode(const uint8_t* data, uint16_t n, std::vector<uint8_t>& out);
+
+    static bool Decode(const uint8_t* data, uint16_t n, std::vector<uint8_t>& out);
+
+    // Changes from base to record as runs of [unchanged count] [changed
+    // count] [changed bytes XOR base]. Trailing unchanged bytes are left out.
+    static void EncodeDelta(const uint8_t* base, const uint8_t* record, uint16_t n,
+                            std::vector<uint8_t>& out);
+
+    static bool DecodeDelta(const uint8_t* delta, uint16_t n, std::vector<uint8_t>& record);
+
+private:
+    struct Reassembly
+    {
+        Address src;
+        uint8_t next_index;
+        uint16_t length;
+        std::vector<uint8_t> data;
+    };
+
+    struct StreamRecord
+    {
+        uint8_t sequence;
+        std::vector<uint8_t> data;
+    };
+
+    struct Stream
+    {
+        Address src;
+        uint8_t id;
+        std::vector<StreamRecord> history;  // Oldest first
+    };
+
+    bool Reassemble(Address src, const uint8_t* fragment, uint16_t n,
+                    std::vector<uint8_t>& message);
+
+    bool Rebuild(Address src, const std::vector<uint8_t>& body, std::vector<uint8_t>& record);
+
+    Shared<bool> compressing;
+    std::vector<Reassembly> reassembly;
+    std::vector<Stream> streams;
+
+    Shared<uint32_t> offered;
+    Shared<uint32_t> compressed;
+    Shared<uint32_t> raw_bytes;
+    Shared<uint32_t> packed_bytes;
+    uint32_t expanded;
+    uint32_t received_bytes;
+    uint32_t expanded_bytes;
+    uint32_t dropped;
+    uint32_t deltas;
+    uint32_t missed_bases;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_PAYLOAD_CODEC_H
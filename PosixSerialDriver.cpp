@@ -0,0 +1,493 @@
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "PosixSerialDriver.h"
+#include "Network.h"
+
+#define RXBEE_POSIX_READ_SIZE   (256)
+#define RXBEE_POSIX_MAX_EVENTS  (4)
+#define RXBEE_POSIX_MAX_ROUNDS  (64)    // Service calls per wake up
+
+namespace RXBee
+{
+
+static bool ToSpeed(uint32_t baud, speed_t& speed)
+{
+    bool valid = true;
+    switch (baud)
+    {
+        case 1200:   speed = B1200;   break;
+        case 2400:   speed = B2400;   break;
+        case 4800:   speed = B4800;   break;
+        case 9600:   speed = B9600;   break;
+        case 19200:  speed = B19200;  break;
+        case 38400:  speed = B38400;  break;
+        case 57600:  speed = B57600;  break;
+        case 115200: speed = B115200; break;
+        case 230400: speed = B230400; break;
+        case 460800: speed = B460800; break;
+        case 921600: speed = B921600; break;
+        default:     valid = false;   break;
+    }
+    return valid;
+}
+
+PosixSerialDriver::PosixSerialDriver(XBeeNetwork* network)
+    : net(network), serial_fd(-1), epoll_fd(-1), event_fd(-1), timer_fd(-1),
+      stopped(false), write_pending(false), elapsed_remainder_ns(0)
+{
+    last_service.tv_sec = 0;
+    last_service.tv_nsec = 0;
+}
+
+PosixSerialDriver::~PosixSerialDriver()
+{
+    Close();
+
+    int* fds[] = { &epoll_fd, &event_fd, &timer_fd };
+    for (uint16_t i = 0; i < 3; ++i)
+    {
+        if (*fds[i] >= 0)
+        {
+            close(*fds[i]);
+            *fds[i] = -1;
+        }
+    }
+}
+
+bool PosixSerialDriver::Open(const char* path, uint32_t baud)
+{
+    speed_t speed;
+    bool success = false;
+
+    if (ToSpeed(baud, speed))
+    {
+        int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+        if (fd >= 0)
+        {
+            struct termios tio;
+            if (tcgetattr(fd, &tio) == 0)
+            {
+                cfmakeraw(&tio);
+                tio.c_cflag |= (CLOCAL | CREAD);
+                tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+                tio.c_cc[VMIN] = 0;
+                tio.c_cc[VTIME] = 0;
+                cfsetispeed(&tio, speed);
+                cfsetospeed(&tio, speed);
+
+                if (tcsetattr(fd, TCSANOW, &tio) == 0)
+                {
+                    tcflush(fd, TCIOFLUSH);
+                    success = Attach(fd);
+                    fd = -1;
+                }
+            }
+
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+    }
+
+    return success;
+}
+
+bool PosixSerialDriver::Attach(int fd)
+{
+    Close();
+
+    serial_fd = fd;
+
+    int flags = fcntl(serial_fd, F_GETFL, 0);
+    if (flags >= 0)
+    {
+        fcntl(serial_fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    bool success = Setup();
+    if (!success)
+    {
+        Close();
+    }
+
+    return success;
+}
+
+bool PosixSerialDriver::Setup()
+{
+    bool success = true;
+    struct epoll_event ev;
+
+    if (epoll_fd < 0)
+    {
+        // Created once and kept until the driver is destroyed, so Wake
+        // never sees a descriptor being closed
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+        int fds[] = { event_fd, timer_fd };
+
+        success = (epoll_fd >= 0) && (event_fd >= 0) && (timer_fd >= 0);
+        for (uint16_t i = 0; (i < 2) && success; ++i)
+        {
+            ev.events = EPOLLIN;
+            ev.data.fd = fds[i];
+            success = (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[i], &ev) == 0);
+        }
+
+        if (!success)
+        {
+            int* created[] = { &epoll_fd, &event_fd, &timer_fd };
+            for (uint16_t i = 0; i < 3; ++i)
+            {
+                if (*created[i] >= 0)
+                {
+                    close(*created[i]);
+                    *created[i] = -1;
+                }
+            }
+        }
+    }
+
+    if (success)
+    {
+        ev.events = EPOLLIN;
+        ev.data.fd = serial_fd;
+        success = (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, serial_fd, &ev) == 0);
+    }
+
+    if (success)
+    {
+        stopped = false;
+        write_pending = false;
+        tx_backlog.clear();
+        elapsed_remainder_ns = 0;
+        clock_gettime(CLOCK_MONOTONIC, &last_service);
+
+        net->GetSerialDataSubject()->Subscribe(this);
+        net->OnSubmit(HandleSubmit, this);
+    }
+
+    return success;
+}
+
+void PosixSerialDriver::Close()
+{
+    if (serial_fd >= 0)
+    {
+        net->OnSubmit(NULL, NULL);
+        net->GetSerialDataSubject()->Unsubscribe(this);
+        if (epoll_fd >= 0)
+        {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, serial_fd, NULL);
+        }
+        close(serial_fd);
+        serial_fd = -1;
+    }
+    tx_backlog.clear();
+    write_pending = false;
+    ArmTimer(0);
+}
+
+int PosixSerialDriver::GetPollFd() const
+{
+    return epoll_fd;
+}
+
+bool PosixSerialDriver::Poll(int32_t timeout_ms)
+{
+    struct epoll_event events[RXBEE_POSIX_MAX_EVENTS];
+    bool success = (serial_fd >= 0) && !stopped;
+
+    if (success)
+    {
+        int n = epoll_wait(epoll_fd, events, RXBEE_POSIX_MAX_EVENTS, timeout_ms);
+
+        if ((n < 0) && (errno != EINTR))
+        {
+            success = false;
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            uint64_t count;
+
+            if ((events[i].data.fd == serial_fd) && (serial_fd >= 0))
+            {
+                int error = 0;
+
+                // A hang up or error is only reported once the data
+                // received before it has been read
+                if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                {
+                    error = ReadSerial();
+                }
+                if ((error == 0) && (events[i].events & (EPOLLERR | EPOLLHUP)))
+                {
+                    error = GetPendingError();
+                }
+
+                if (error != 0)
+                {
+                    Disconnect(error);
+                }
+                else if (events[i].events & EPOLLOUT)
+                {
+                    FlushTx();
+                }
+            }
+            else if (events[i].data.fd == event_fd)
+            {
+                // Submissions and wake ups only need the Service round below
+                while (read(event_fd, &count, sizeof(count)) > 0) { }
+            }
+            else if (events[i].data.fd == timer_fd)
+            {
+                while (read(timer_fd, &count, sizeof(count)) > 0) { }
+            }
+        }
+
+        if (!stopped)
+        {
+            ServiceNetwork();
+        }
+
+        success = success && !stopped;
+    }
+
+    return success;
+}
+
+void PosixSerialDriver::Run()
+{
+    while (Poll(-1)) { }
+}
+
+void PosixSerialDriver::Stop()
+{
+    stopped = true;
+    Wake();
+}
+
+void PosixSerialDriver::Wake()
+{
+    if (event_fd >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t written = write(event_fd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+int PosixSerialDriver::ReadSerial()
+{
+    uint8_t buff[RXBEE_POSIX_READ_SIZE];
+    ssize_t n;
+    int error = 0;
+
+    do
+    {
+        n = read(serial_fd, buff, sizeof(buff));
+        if (n > 0)
+        {
+            net->OnNext(buff, static_cast<uint16_t>(n));
+        }
+    }
+    while ((n > 0) || ((n < 0) && (errno == EINTR)));
+
+    if (n == 0)
+    {
+        // End of file, the other side hung up
+        error = EPIPE;
+    }
+    else if (errno != EAGAIN)
+    {
+        error = errno;
+    }
+
+    return error;
+}
+
+int PosixSerialDriver::GetPendingError()
+{
+    int error = 0;
+    socklen_t len = sizeof(error);
+
+    // Only sockets keep the error, terminals report it through read
+    if ((getsockopt(serial_fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0) || (error == 0))
+    {
+        error = EIO;
+    }
+
+    return error;
+}
+
+void PosixSerialDriver::Disconnect(int error)
+{
+    // The descriptor stays readable once hung up, keep it out of the set
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, serial_fd, NULL);
+    net->OnSubmit(NULL, NULL);
+    net->GetSerialDataSubject()->Unsubscribe(this);
+    close(serial_fd);
+    serial_fd = -1;
+    tx_backlog.clear();
+    write_pending = false;
+    stopped = true;
+
+    net->OnError(error);
+}
+
+void PosixSerialDriver::ServiceNetwork()
+{
+    uint16_t rounds = 0;
+    int32_t timeout;
+
+    do
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        // Carry sub-millisecond time into the next round
+        elapsed_remainder_ns += (now.tv_sec - last_service.tv_sec) * 1000000000LL +
+                                (now.tv_nsec - last_service.tv_nsec);
+        last_service = now;
+
+        uint32_t milliseconds = static_cast<uint32_t>(elapsed_remainder_ns / 1000000);
+        elapsed_remainder_ns -= static_cast<int64_t>(milliseconds) * 1000000;
+
+        net->Service(milliseconds);
+        timeout = net->GetNextTimeout();
+        rounds++;
+    }
+    while ((timeout == 0) && (rounds < RXBEE_POSIX_MAX_ROUNDS));
+
+    if ((timeout == 0) && (event_fd >= 0))
+    {
+        // Yield to other events, then continue
+        Wake();
+    }
+
+    ArmTimer(timeout);
+}
+
+void PosixSerialDriver::ArmTimer(int32_t milliseconds)
+{
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = 0;
+    spec.it_interval.tv_nsec = 0;
+    spec.it_value.tv_sec = 0;
+    spec.it_value.tv_nsec = 0;
+
+    if (milliseconds > 0)
+    {
+        // Round up so the transaction has expired when the timer fires
+        int64_t ns = static_cast<int64_t>(milliseconds) * 1000000 - elapsed_remainder_ns;
+        if (ns <= 0)
+        {
+            ns = 1;
+        }
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+    }
+
+    // A zero value disarms the timer
+    timerfd_settime(timer_fd, 0, &spec, NULL);
+}
+
+void PosixSerialDriver::OnNext(const std::vector<uint8_t>& data)
+{
+    if (!data.empty())
+    {
+        OnNext(&data[0], data.size());
+    }
+}
+
+void PosixSerialDriver::OnNext(const uint8_t* data, const uint16_t len)
+{
+    tx_backlog.insert(tx_backlog.end(), data, data + len);
+    FlushTx();
+}
+
+void PosixSerialDriver::FlushTx()
+{
+    size_t offset = 0;
+
+    while (offset < tx_backlog.size())
+    {
+        ssize_t n = write(serial_fd, &tx_backlog[offset], tx_backlog.size() - offset);
+
+        if (n > 0)
+        {
+            offset += n;
+        }
+        else if ((n < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        else
+        {
+            if ((n < 0) && (errno != EAGAIN))
+            {
+                net->OnError(errno);
+                offset = tx_backlog.size();
+            }
+            break;
+        }
+    }
+
+    tx_backlog.erase(tx_backlog.begin(), tx_backlog.begin() + offset);
+    UpdateWriteInterest();
+}
+
+void PosixSerialDriver::UpdateWriteInterest()
+{
+    bool want_write = !tx_backlog.empty();
+
+    if ((want_write != write_pending) && (epoll_fd >= 0))
+    {
+        struct epoll_event ev;
+        ev.events = EPOLLIN | (want_write ? static_cast<uint32_t>(EPOLLOUT) : 0);
+        ev.data.fd = serial_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, serial_fd, &ev);
+        write_pending = want_write;
+    }
+}
+
+void PosixSerialDriver::OnComplete()
+{
+
+}
+
+void PosixSerialDriver::OnError(const int32_t)
+{
+    // The network ended the stream, drop what it did not get to send
+    tx_backlog.clear();
+    UpdateWriteInterest();
+    Stop();
+}
+
+void PosixSerialDriver::HandleSubmit(XBeeNetwork*, void* context)
+{
+    PosixSerialDriver* driver = static_cast<PosixSerialDriver*>(context);
+
+    if (driver != NULL)
+    {
+        driver->Wake();
+    }
+}
+
+} // namespace RXBee
+
+#endif // __linux__
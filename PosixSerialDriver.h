@@ -0,0 +1,101 @@
+#ifndef RXBEE_POSIX_SERIAL_DRIVER_H
+#define RXBEE_POSIX_SERIAL_DRIVER_H
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+#include <vector>
+
+#include "SerialDataObserver.h"
+
+namespace RXBee
+{
+
+class XBeeNetwork;
+
+// Event driven driver for Linux hosts. Owns the serial file descriptor and
+// an epoll set with an eventfd (transaction submitted) and a timerfd (next
+// transaction deadline), so XBeeNetwork::Service only runs when bytes
+// arrive, a transaction is pended or a timeout is due.
+//
+// Poll/Run must be called from the thread that services the network.
+// Transactions may be pended from other threads when the library is built
+// with RXBEE_THREADED. Open, Attach and Close must only be called while no
+// other thread pends transactions, i.e. before they start and after they
+// stop.
+class PosixSerialDriver : public SerialDataObserver
+{
+public:
+    PosixSerialDriver(XBeeNetwork* network);
+    virtual ~PosixSerialDriver();
+
+    // Opens a tty in raw 8N1 mode
+    bool Open(const char* path, uint32_t baud);
+
+    // Uses an already open descriptor, e.g. one side of a pty pair.
+    // The driver takes ownership and closes it.
+    bool Attach(int fd);
+
+    // Closes the port. The epoll, event and timer descriptors are kept
+    // for the next Open or Attach until the driver is destroyed.
+    void Close();
+
+    // Epoll descriptor, readable whenever Poll has work to do. Allows the
+    // driver to be nested in an application's own event loop. Valid from
+    // the first successful Open or Attach on.
+    int GetPollFd() const;
+
+    // Waits up to timeout_ms (-1 forever) for one round of events and
+    // services the network. Returns false on error or after Stop().
+    // When the port hangs up or fails it is closed and the error passed
+    // to XBeeNetwork::OnError, Open or Attach starts over.
+    bool Poll(int32_t timeout_ms);
+
+    // Polls until Stop() is called
+    void Run();
+
+    // Thread safe
+    void Stop();
+
+    // Thread safe, forces a Service round
+    void Wake();
+
+    void OnNext(const std::vector<uint8_t>& data);
+    void OnNext(const uint8_t* data, const uint16_t len);
+    void OnComplete();
+    void OnError(const int32_t error_code);
+
+private:
+    static void HandleSubmit(XBeeNetwork* source, void* context);
+
+    bool Setup();
+
+    // Reads until the port is drained, returns the error that ended the
+    // read or 0 when there is nothing more to read
+    int ReadSerial();
+    int GetPendingError();
+    void Disconnect(int error);
+    void FlushTx();
+    void ServiceNetwork();
+    void ArmTimer(int32_t milliseconds);
+    void UpdateWriteInterest();
+
+    XBeeNetwork* net;
+    int serial_fd;
+    int epoll_fd;
+    int event_fd;
+    int timer_fd;
+    std::atomic<bool> stopped;
+    bool write_pending;
+    std::vector<uint8_t> tx_backlog;
+    struct timespec last_service;
+    int64_t elapsed_remainder_ns;
+};
+
+} // namespace RXBee
+
+#endif // __linux__
+
+#endif // RXBEE_POSIX_SERIAL_DRIVER_H
@@ -7,6 +7,7 @@
 extern "C" {
 #endif
 
+// Capacities of XBeeNetwork, see BasicXBeeNetwork for per instance sizes
 #ifndef RXBEE_RX_BUFFER_SIZE
     #define RXBEE_RX_BUFFER_SIZE   (2048)   // Size of receive buffer
 #endif
@@ -20,14 +21,65 @@ extern "C" {
     #define RXBEE_DEBUG 0
 #endif
 
+// Log messages up to this level are recorded, see Log.h (0 none, 1 errors,
+// 2 warnings, 3 info, 4 debug)
+#ifndef RXBEE_LOG_LEVEL
+    #if RXBEE_DEBUG
+        #define RXBEE_LOG_LEVEL 4
+    #else
+        #define RXBEE_LOG_LEVEL 3
+    #endif
+#endif
+
 #ifndef RXBEE_TRANSACTION_TIMEOUT
     #define RXBEE_TRANSACTION_TIMEOUT 150 
 #endif
 
+// First attempt of a pended transaction, longer to allow for mesh hops
+#ifndef RXBEE_FIRST_ATTEMPT_TIMEOUT
+    #define RXBEE_FIRST_ATTEMPT_TIMEOUT 300
+#endif
+
 #ifndef RXBEE_TRANSACTION_RETRY
     #define RXBEE_TRANSACTION_RETRY 2 
 #endif
 
+// Node discovery deadline, the radio's default NT (13 s) plus margin
+#ifndef RXBEE_DISCOVERY_TIMEOUT
+    #define RXBEE_DISCOVERY_TIMEOUT 14000
+#endif
+
+// Set to 1 when OnNext, Service and BeginTransaction are called from
+// different threads (host builds only, requires <atomic>)
+#ifndef RXBEE_THREADED
+    #define RXBEE_THREADED 0
+#endif
+
+// Set to 1 to record latency histograms, see LatencyStats (about 800
+// bytes of RAM per histogram in use)
+#ifndef RXBEE_HISTOGRAMS
+    #define RXBEE_HISTOGRAMS 0
+#endif
+
+// Builds the frame codec for one API mode only, 0 transparent, 1 unescaped
+// or 2 escaped (the radio's AP setting). -1 selects the mode at run time,
+// see XBeeNetwork::SetApiMode.
+#ifndef RXBEE_FIXED_API_MODE
+    #define RXBEE_FIXED_API_MODE (-1)
+#endif
+
+// Set to 1 on Linux hosts to map the receive ring twice back to back, so
+// received frames are always contiguous and unescaped (AP=1) frames are
+// parsed in place without a copy. RXBEE_RX_BUFFER_SIZE must be a
+// multiple of the page size, e.g. 4096.
+#ifndef RXBEE_MIRRORED_RING
+    #define RXBEE_MIRRORED_RING 0
+#endif
+
+#ifndef RXBEE_CACHE_LINE_SIZE
+    #define RXBEE_CACHE_LINE_SIZE 64
+#endif
+
     /* Provide C++ Compatibility */
 #ifdef __cplusplus
 }
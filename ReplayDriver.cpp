@@ -0,0 +1,337 @@
+
+#include <string.h>
+
+#include "ReplayDriver.h"
+#include "WireCapture.h"
+#include "Network.h"
+
+#define RXBEE_REPLAY_PCAP_HEADER        (24)
+#define RXBEE_REPLAY_PCAP_RECORD        (16)
+#define RXBEE_REPLAY_PREFIX_RECORD      (7)     // Direction, time, length
+
+namespace RXBee
+{
+
+static uint32_t ReadLittle(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static uint32_t ReadBig(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+ReplayDriver::ReplayDriver(XBeeNetwork* network)
+    : net(network), data(NULL), next(0), mode(Mode::FAST), delay(NULL), clock(NULL),
+      wall_start(0), started(false), now(0), serviced(0), completed_base(0),
+      timed_out_base(0)
+{
+    memset(&result, 0, sizeof(result));
+    net->GetSerialDataSubject()->Subscribe(this);
+}
+
+ReplayDriver::~ReplayDriver()
+{
+    net->GetSerialDataSubject()->Unsubscribe(this);
+}
+
+bool ReplayDriver::Load(const uint8_t* capture, uint32_t len)
+{
+    bool valid = false;
+
+    data = capture;
+    records.clear();
+    tx_records.clear();
+    next = 0;
+    started = false;
+    now = 0;
+    serviced = 0;
+    memset(&result, 0, sizeof(result));
+
+    if ((len >= RXBEE_REPLAY_PCAP_HEADER) && (ReadLittle(capture) == 0xA1B2C3D4))
+    {
+        valid = LoadPcap(capture, len);
+    }
+    else
+    {
+        valid = LoadLengthPrefixed(capture, len);
+    }
+
+    if (valid && !records.empty())
+    {
+        // Replay starts at virtual time 0
+        uint64_t first = records[0].time;
+        for (uint32_t i = 0; i < records.size(); ++i)
+        {
+            records[i].time -= first;
+            if (records[i].direction == RXBEE_CAPTURE_TX)
+            {
+                tx_records.push_back(i);
+            }
+        }
+        result.tx_expected = tx_records.size();
+        result.virtual_us = records.back().time;
+    }
+    else if (!valid)
+    {
+        records.clear();
+    }
+
+    return valid;
+}
+
+bool ReplayDriver::LoadPcap(const uint8_t* capture, uint32_t len)
+{
+    bool valid = (ReadLittle(&capture[20]) == RXBEE_CAPTURE_LINKTYPE);
+    uint32_t i = RXBEE_REPLAY_PCAP_HEADER;
+
+    while (valid && (i < len))
+    {
+        uint32_t size = 0;
+
+        if ((len - i) < RXBEE_REPLAY_PCAP_RECORD)
+        {
+            valid = false;
+        }
+        else
+        {
+            size = ReadLittle(&capture[i + 8]);
+            valid = (size >= 1) && (size <= 0x10000) &&
+                    ((len - i - RXBEE_REPLAY_PCAP_RECORD) >= size);
+        }
+
+        if (valid)
+        {
+            Record r;
+            r.time = ReadLittle(&capture[i]) * 1000000ULL + ReadLittle(&capture[i + 4]);
+            r.direction = capture[i + RXBEE_REPLAY_PCAP_RECORD];
+            r.offset = i + RXBEE_REPLAY_PCAP_RECORD + 1;
+            r.len = size - 1;
+            records.push_back(r);
+            i += RXBEE_REPLAY_PCAP_RECORD + size;
+        }
+    }
+
+    return valid;
+}
+
+bool ReplayDriver::LoadLengthPrefixed(const uint8_t* capture, uint32_t len)
+{
+    bool valid = true;
+    uint32_t i = 0;
+    uint64_t time = 0;
+
+    while (valid && (i < len))
+    {
+        uint16_t size = 0;
+
+        if ((len - i) < RXBEE_REPLAY_PREFIX_RECORD)
+        {
+            valid = false;
+        }
+        else
+        {
+            size = (capture[i + 5] << 8) | capture[i + 6];
+            valid = (capture[i] <= RXBEE_CAPTURE_TX) &&
+                    ((len - i - RXBEE_REPLAY_PREFIX_RECORD) >= size);
+        }
+
+        if (valid)
+        {
+            // Extend the 32 bit timestamps across wrap, chunks merged out of
+            // order keep the time before them
+            uint32_t stamp = ReadBig(&capture[i + 1]);
+            uint32_t delta = stamp - static_cast<uint32_t>(time);
+            if (records.empty())
+            {
+                time = stamp;
+            }
+            else if (static_cast<int32_t>(delta) > 0)
+            {
+                time += delta;
+            }
+
+            Record r;
+            r.time = time;
+            r.direction = capture[i];
+            r.offset = i + RXBEE_REPLAY_PREFIX_RECORD;
+            r.len = size;
+            records.push_back(r);
+            i += RXBEE_REPLAY_PREFIX_RECORD + size;
+        }
+    }
+
+    return valid;
+}
+
+void ReplayDriver::SetMode(Mode mode, Delay delay)
+{
+    this->mode = mode;
+    this->delay = delay;
+}
+
+void ReplayDriver::SetClock(Clock clock)
+{
+    this->clock = clock;
+}
+
+uint64_t ReplayDriver::GetTime() const
+{
+    return now;
+}
+
+void ReplayDriver::Wait(uint64_t time)
+{
+    uint64_t wait = (time > now) ? (time - now) : 0;
+
+    if (clock != NULL)
+    {
+        // Subtract the time spent servicing since the replay started
+        uint32_t elapsed = clock() - wall_start;
+        wait = (time > elapsed) ? (time - elapsed) : 0;
+    }
+
+    while (wait > 0)
+    {
+        uint32_t part = (wait > 0xFFFFFFFFULL) ? 0xFFFFFFFF : static_cast<uint32_t>(wait);
+        delay(part);
+        wait -= part;
+    }
+}
+
+void ReplayDriver::Advance(uint64_t time)
+{
+    uint16_t rounds = 0;
+
+    // Step from one deadline of the network to the next
+    while ((serviced + 1000) <= time)
+    {
+        uint32_t gap = static_cast<uint32_t>((time - serviced) / 1000);
+        uint32_t step = gap;
+        int32_t timeout = net->GetNextTimeout();
+
+        if ((timeout >= 0) && (static_cast<uint32_t>(timeout) < gap))
+        {
+            step = timeout;
+        }
+        if ((step == 0) && (++rounds >= RXBEE_REPLAY_MAX_ROUNDS))
+        {
+            step = gap;
+        }
+
+        net->Service(step);
+        serviced += step * 1000ULL;
+    }
+
+    now = time;
+}
+
+void ReplayDriver::Drain()
+{
+    uint16_t rounds = 0;
+
+    do
+    {
+        net->Service(0);
+        rounds++;
+    }
+    while ((net->GetNextTimeout() == 0) && (rounds < RXBEE_REPLAY_MAX_ROUNDS));
+}
+
+bool ReplayDriver::Step()
+{
+    bool more = (next < records.size());
+
+    if (more)
+    {
+        if (!started)
+        {
+            MetricsSnapshot snapshot;
+            net->GetMetrics(snapshot);
+            completed_base = snapshot.transactions_completed;
+            timed_out_base = snapshot.transactions_timed_out;
+            wall_start = (clock != NULL) ? clock() : 0;
+            started = true;
+        }
+
+        const Record& r = records[next++];
+
+        if ((mode == Mode::REAL_TIME) && (delay != NULL))
+        {
+            Wait(r.time);
+        }
+        Advance(r.time);
+
+        // Transmitted chunks only move the clock, the application writes
+        // them again
+        if (r.direction == RXBEE_CAPTURE_RX)
+        {
+            result.rx_chunks++;
+            result.rx_bytes += r.len;
+            net->OnNext(&data[r.offset], r.len);
+            Drain();
+        }
+
+        if (clock != NULL)
+        {
+            result.wall_us = clock() - wall_start;
+        }
+    }
+
+    return more;
+}
+
+void ReplayDriver::Run()
+{
+    while (Step())
+    {
+
+    }
+}
+
+void ReplayDriver::GetResult(ReplayResult& result) const
+{
+    MetricsSnapshot snapshot;
+    net->GetMetrics(snapshot);
+
+    result = this->result;
+    if (started)
+    {
+        result.transactions_completed = snapshot.transactions_completed - completed_base;
+        result.transactions_timed_out = snapshot.transactions_timed_out - timed_out_base;
+    }
+}
+
+void ReplayDriver::OnNext(const std::vector<uint8_t>& data)
+{
+    if (!data.empty())
+    {
+        OnNext(&data[0], data.size());
+    }
+}
+
+void ReplayDriver::OnNext(const uint8_t* data, const uint16_t len)
+{
+    if (result.tx_sent < tx_records.size())
+    {
+        const Record& r = records[tx_records[result.tx_sent]];
+        if ((r.len == len) && (memcmp(&this->data[r.offset], data, len) == 0))
+        {
+            result.tx_matched++;
+        }
+    }
+    result.tx_sent++;
+}
+
+void ReplayDriver::OnComplete()
+{
+
+}
+
+void ReplayDriver::OnError(const int32_t)
+{
+
+}
+
+} // namespace RXBee
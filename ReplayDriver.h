@@ -0,0 +1,131 @@
+#ifndef RXBEE_REPLAY_DRIVER_H
+#define RXBEE_REPLAY_DRIVER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "SerialDataObserver.h"
+
+#define RXBEE_REPLAY_MAX_ROUNDS     (64)    // Service calls per received chunk
+
+namespace RXBee
+{
+
+class XBeeNetwork;
+
+struct ReplayResult
+{
+    uint32_t rx_chunks;                 // Received chunks fed to OnNext
+    uint32_t rx_bytes;
+    uint32_t tx_expected;               // Frames written in the capture
+    uint32_t tx_sent;                   // Frames written during the replay
+    uint32_t tx_matched;                // Sent frames identical to the captured one
+    uint32_t transactions_completed;
+    uint32_t transactions_timed_out;
+    uint64_t virtual_us;                // Capture time replayed
+    uint32_t wall_us;                   // Time taken, 0 without a clock
+};
+
+// Replays a WireCapture recording into an XBeeNetwork. Received chunks are
+// passed to OnNext with their original boundaries and Service is driven on
+// a virtual clock taken from the capture timestamps, stepping from one
+// GetNextTimeout to the next, so timeouts and retries happen at the same
+// points in the traffic as they did live.
+//
+// Frames the network writes are compared with the transmitted frames of
+// the capture in order. The application issues its transactions between
+// Step calls, as it did when the capture was taken, and checks the result
+// against the original run:
+//
+//   ReplayDriver replay(&net);
+//   replay.Load(&capture[0], capture.size());
+//   while (replay.Step())
+//   {
+//       Application(replay.GetTime());
+//   }
+//   replay.GetResult(result);
+//
+// FAST mode replays as fast as possible and doubles as a benchmark of the
+// parser and dispatcher on recorded traffic. REAL_TIME mode waits between
+// chunks with the given delay function.
+class ReplayDriver : public SerialDataObserver
+{
+public:
+    typedef uint32_t (*Clock)(void);
+    typedef void (*Delay)(uint32_t microseconds);
+
+    enum class Mode
+    {
+        FAST,
+        REAL_TIME
+    };
+
+    ReplayDriver(XBeeNetwork* network);
+    virtual ~ReplayDriver();
+
+    // Indexes a pcap or length prefixed capture, see WireCapture. The
+    // buffer is not copied and must outlive the replay. Returns false when
+    // the capture is malformed.
+    bool Load(const uint8_t* capture, uint32_t len);
+
+    void SetMode(Mode mode, Delay delay);
+
+    // Microsecond clock for the wall time of the replay and to keep
+    // REAL_TIME mode in step with the capture
+    void SetClock(Clock clock);
+
+    // Replays the next chunk, false once the capture is exhausted
+    bool Step();
+
+    // Replays everything left
+    void Run();
+
+    // Virtual microseconds since the first chunk
+    uint64_t GetTime() const;
+
+    void GetResult(ReplayResult& result) const;
+
+    void OnNext(const std::vector<uint8_t>& data);
+    void OnNext(const uint8_t* data, const uint16_t len);
+    void OnComplete();
+    void OnError(const int32_t error_code);
+
+private:
+    struct Record
+    {
+        uint64_t time;
+        uint32_t offset;
+        uint16_t len;
+        uint8_t direction;
+    };
+
+    bool LoadPcap(const uint8_t* capture, uint32_t len);
+    bool LoadLengthPrefixed(const uint8_t* capture, uint32_t len);
+
+    void Advance(uint64_t time);
+    void Wait(uint64_t time);
+    void Drain();
+
+    XBeeNetwork* net;
+    const uint8_t* data;
+    std::vector<Record> records;
+    std::vector<uint32_t> tx_records;
+    uint32_t next;
+
+    Mode mode;
+    Delay delay;
+    Clock clock;
+    uint32_t wall_start;
+    bool started;
+
+    uint64_t now;                       // Virtual time
+    uint64_t serviced;                  // Virtual time passed to Service
+
+    ReplayResult result;
+    uint32_t completed_base;
+    uint32_t timed_out_base;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_REPLAY_DRIVER_H
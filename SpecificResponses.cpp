@@ -7,12 +7,13 @@ namespace Response {
     
 XBeeATCommand ToXbeeATCmd(char* str)
 {
-    XBeeATCommand cmd;    
-    for (int16_t i = 0; i <= static_cast<int16_t>(XBeeATCommand::INVALID); ++i)
+    XBeeATCommand cmd = XBeeATCommand::INVALID;    
+    for (int16_t i = 0; i < static_cast<int16_t>(XBeeATCommand::INVALID); ++i)
     {
         if (strcmp(str, XBEE_AT_CMD[i]) == 0)
         {
             cmd = static_cast<XBeeATCommand>(i);
+            break;
         }
     }
     
@@ -435,9 +436,11 @@ FN_Rsp Response::FN() const
         offset += 8;
         uint16_t len;
         frame->GetField(offset, rsp.node_identifier, len, XBEE_AT_NI_IDENT_LEN); 
-        offset += len + 2;
+        offset += len + 3;  // Null terminator and parent address
         frame->GetFields(offset, rsp.device_type, rsp.status, rsp.profile_id, rsp.mfr_id);
         offset += 6;
+        rsp.digi_device_type = 0;
+        rsp.last_hop_rssi = 0;
         if (frame->GetField(offset, rsp.digi_device_type))
         { 
             offset += 4; 
@@ -646,9 +649,11 @@ ND_Rsp Response::ND() const
         offset += 8;
         uint16_t len;
         frame->GetField(offset, rsp.node_identifier, len, XBEE_AT_NI_IDENT_LEN); 
-        offset += len + 2;
+        offset += len + 3;  // Null terminator and parent address
         frame->GetFields(offset, rsp.device_type, rsp.status, rsp.profile_id, rsp.mfr_id);
         offset += 6;
+        rsp.digi_device_type = 0;
+        rsp.last_hop_rssi = 0;
         if (frame->GetField(offset, rsp.digi_device_type))
         { 
             offset += 4; 
@@ -1128,21 +1133,24 @@ ModemStatusUpdate::ModemStatusUpdate(ApiFrame& rsp)
 }
 
 
-RouteInformation::RouteInformation(ApiFrame& rsp)
+RouteInformation::RouteInformation(ApiFrame& rsp) : frame(NULL), extracted(false),
+        trace(false), timestamp(0), ack_timeout_count(0), tx_blocked_count(0),
+        destination_addr(0), source_addr(0), responder_addr(0), receiver_addr(0)
 {
-    if (rsp.extracted && (rsp.api_id == ApiID::MODEM_STATUS))
+    if (rsp.extracted && (rsp.api_id == ApiID::ROUTE_INFO_PACKET))
     {
         frame = rsp.frame;
         uint8_t source;
         uint8_t len;
+        uint8_t reserved;
         extracted = frame->GetFields(XBEE_RESP_RTE_INFO_INDEX, source, len,
-                timestamp, ack_timeout_count, tx_blocked_count, 
+                timestamp, ack_timeout_count, tx_blocked_count, reserved,
                 destination_addr, source_addr, responder_addr,
                 receiver_addr);
         
         if (extracted)
         {
-            trace = (source == 0x12);
+            trace = (source == XBEE_ROUTE_EVENT_TRACE);
         }
     }        
 }
@@ -1172,9 +1180,12 @@ ReceivePacket::ReceivePacket(ApiFrame& rsp, std::vector<uint8_t>& buffer)
     }        
 }
 
-ExplicitReceivePacket::ExplicitReceivePacket(ApiFrame& rsp) : data_length(0)
+ExplicitReceivePacket::ExplicitReceivePacket(ApiFrame& rsp) : frame(NULL),
+        extracted(false), sender_addr(0), source_endpoint(0),
+        destination_endpoint(0), cluster_id(0), profile_id(0), options(0),
+        data_length(0)
 {
-    if (rsp.extracted && (rsp.api_id == ApiID::RECEIVE_PACKET))
+    if (rsp.extracted && (rsp.api_id == ApiID::EXPLICIT_RX_INDICATOR))
     {
         frame = rsp.frame;
         uint16_t reserved;
@@ -1188,43 +1199,114 @@ ExplicitReceivePacket::ExplicitReceivePacket(ApiFrame& rsp) : data_length(0)
     }        
 }
 
-ExplicitIOSample::ExplicitIOSample(ApiFrame& rsp)
+ExplicitReceivePacket::ExplicitReceivePacket(ApiFrame& rsp, std::vector<uint8_t>& buffer)
+        : frame(NULL), extracted(false), sender_addr(0), source_endpoint(0),
+        destination_endpoint(0), cluster_id(0), profile_id(0), options(0),
+        data_length(0)
 {
-    if (rsp.extracted && (rsp.api_id == ApiID::RECEIVE_PACKET))
+    if (rsp.extracted && (rsp.api_id == ApiID::EXPLICIT_RX_INDICATOR))
+    {
+        frame = rsp.frame;
+        uint16_t reserved;
+        extracted = frame->GetFields(XBEE_RESP_EXP_RX_INDEX, sender_addr,
+                reserved, source_endpoint, destination_endpoint, cluster_id,
+                profile_id, options);
+        if (extracted)
+        {
+            frame->GetData(XBEE_RESP_EXP_RX_DATA_INDEX, buffer);
+        }
+    }        
+}
+
+ExplicitIOSample::ExplicitIOSample(ApiFrame& rsp) : frame(NULL), extracted(false),
+        source_addr(0), source_nework_addr(0), options(0), number_of_samples(0),
+        digital_channel_mask(0), analog_channel_mask(0), digital_samples(0),
+        supply_voltage(0)
+{
+    for (uint8_t i = 0; i < XBEE_IO_ANALOG_CHANNELS; ++i)
+    {
+        analog_samples[i] = 0;
+    }
+    
+    if (rsp.extracted && (rsp.api_id == ApiID::IO_DATA_SAMPLE_RX_INDICATOR))
     {
         frame = rsp.frame;
-        extracted = frame->GetFields(XBEE_RESP_EXP_RX_INDEX, source_addr,
+        extracted = frame->GetFields(XBEE_RESP_IO_SAMPLE_INDEX, source_addr,
                 source_nework_addr, options, number_of_samples,
                 digital_channel_mask, analog_channel_mask);
         
-        // TODO: Are digital sample bytes always in the message?
-        // TODO: Are analog sample bytes always in the message?
+        // Sample bytes follow only for the enabled channels, digital first
+        // and then the analog channels in mask order
+        uint16_t index = XBEE_RESP_IO_SAMPLE_DATA_INDEX;
+        if (extracted && (digital_channel_mask != 0))
+        {
+            extracted = frame->GetField(index, digital_samples);
+            index += sizeof(digital_samples);
+        }
+        
+        for (uint8_t i = 0; extracted && (i < XBEE_IO_ANALOG_CHANNELS); ++i)
+        {
+            if (analog_channel_mask & (1 << i))
+            {
+                extracted = frame->GetField(index, analog_samples[i]);
+                index += sizeof(analog_samples[i]);
+            }
+        }
+        
+        if (extracted && (analog_channel_mask & XBEE_IO_SUPPLY_VOLTAGE))
+        {
+            extracted = frame->GetField(index, supply_voltage);
+        }
     }        
 }
 
-NodeID::NodeID(ApiFrame& rsp)
+NodeID::NodeID(ApiFrame& rsp) : frame(NULL), extracted(false), source_addr(0),
+        options(0), remote_addr(0), identifier_len(0), type(DeviceType::INVALID),
+        pushbutton(false), digi_profile_id(0), digi_mfr_id(0),
+        digi_dd_value_included(false), digi_dd_value(0), rssi_included(false), rssi(0)
 {
-    if (rsp.extracted && (rsp.api_id == ApiID::MODEM_STATUS))
+    identifier[0] = '\0';
+    
+    if (rsp.extracted && (rsp.api_id == ApiID::NODE_ID_INDICATOR))
     {
         frame = rsp.frame;
-        type = DeviceType::INVALID;
         uint8_t type_i;
-        uint8_t pushbutton_i;
+        uint8_t event_i;
         uint16_t reserved;
+        uint16_t offset = XBEE_RESP_NODE_ID_STR_INDEX;
         extracted = frame->GetFields(XBEE_RESP_NODE_ID_INDEX, source_addr,
                 reserved, options, reserved, remote_addr);
         
         if (extracted)
         {
-            extracted = frame->GetField(XBEE_RESP_NODE_ID_STR_INDEX, identifier, 
+            // At most XBEE_AT_NI_IDENT_LEN characters, the terminator
+            // follows them either way and is skipped
+            extracted = frame->GetField(offset, identifier, 
                     identifier_len, XBEE_AT_NI_IDENT_LEN);
+            identifier[identifier_len] = '\0';
+            offset += identifier_len + 1;
+        }
+        if (extracted)
+        {
+            extracted = frame->GetFields(offset, reserved, type_i, event_i,
+                    digi_profile_id, digi_mfr_id);
+            offset += 8;
+            pushbutton = (event_i == 1);
         }
         if (extracted)
         {
-            extracted = frame->GetFields(XBEE_RESP_NODE_ID_STR_INDEX + identifier_len,
-                    type_i, pushbutton_i, digi_profile_id, digi_mfr_id);
-            
-            // TODO:: Optional fields
+            // Optional device type identifier and RSSI, present depending on NO
+            uint16_t remaining = XBEE_FRAME_API_ID_INDEX + frame->GetSize() - offset;
+            if (remaining >= sizeof(digi_dd_value))
+            {
+                digi_dd_value_included = frame->GetField(offset, digi_dd_value);
+                offset += sizeof(digi_dd_value);
+                remaining -= sizeof(digi_dd_value);
+            }
+            if (remaining > 0)
+            {
+                rssi_included = frame->GetField(offset, rssi);
+            }
         }
         
         if (extracted)
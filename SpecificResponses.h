@@ -22,6 +22,8 @@
 #define XBEE_RESP_RX_DATA_INDEX         (15)
 #define XBEE_RESP_EXP_RX_INDEX          (4)
 #define XBEE_RESP_EXP_RX_DATA_INDEX     (21)
+#define XBEE_RESP_IO_SAMPLE_INDEX       (4)
+#define XBEE_RESP_IO_SAMPLE_DATA_INDEX  (19)
 #define XBEE_RESP_NODE_ID_INDEX         (4)
 #define XBEE_RESP_NODE_ID_STR_INDEX     (25)
 
@@ -30,6 +32,12 @@
 #define XBEE_AT_NI_IDENT_LEN    (20)
 #define XBEE_AT_VL_VER_LEN      (64)
 
+#define XBEE_ROUTE_EVENT_NACK           (0x11)
+#define XBEE_ROUTE_EVENT_TRACE          (0x12)
+
+#define XBEE_IO_ANALOG_CHANNELS         (4)     // AD0 to AD3, mask bits 0 to 3
+#define XBEE_IO_SUPPLY_VOLTAGE          (0x80)  // Analog mask bit, V+ threshold
+
 namespace RXBee {
 namespace Response {
     
@@ -541,6 +549,37 @@ struct Response
     WH_Rsp WH() const;
 };
 
+// Compile time mapping from a command to its name and response type,
+// e.g. Accessor<XBeeATCommand::NP>::Get(rsp) returns an NP_Rsp
+template<XBeeATCommand C>
+struct Accessor;
+
+#define RXBEE_AT_ACCESSOR(ID) \
+    template<> struct Accessor<XBeeATCommand::ID> \
+    { \
+        typedef ID##_Rsp Type; \
+        static const char* Name() { return XBEE_CMD(ID); } \
+        static Type Get(const Response& rsp) { return rsp.ID(); } \
+    };
+
+RXBEE_AT_ACCESSOR(AF) RXBEE_AT_ACCESSOR(AO) RXBEE_AT_ACCESSOR(AP) RXBEE_AT_ACCESSOR(AV) RXBEE_AT_ACCESSOR(BC) RXBEE_AT_ACCESSOR(BD)
+RXBEE_AT_ACCESSOR(BH) RXBEE_AT_ACCESSOR(CC) RXBEE_AT_ACCESSOR(CE) RXBEE_AT_ACCESSOR(CI) RXBEE_AT_ACCESSOR(CK) RXBEE_AT_ACCESSOR(CM)
+RXBEE_AT_ACCESSOR(CT) RXBEE_AT_ACCESSOR(D0) RXBEE_AT_ACCESSOR(D1) RXBEE_AT_ACCESSOR(D2) RXBEE_AT_ACCESSOR(D3) RXBEE_AT_ACCESSOR(D4)
+RXBEE_AT_ACCESSOR(D5) RXBEE_AT_ACCESSOR(D6) RXBEE_AT_ACCESSOR(D7) RXBEE_AT_ACCESSOR(D8) RXBEE_AT_ACCESSOR(D9) RXBEE_AT_ACCESSOR(DB)
+RXBEE_AT_ACCESSOR(DD) RXBEE_AT_ACCESSOR(DE) RXBEE_AT_ACCESSOR(DH) RXBEE_AT_ACCESSOR(DL) RXBEE_AT_ACCESSOR(DN) RXBEE_AT_ACCESSOR(EA)
+RXBEE_AT_ACCESSOR(ED) RXBEE_AT_ACCESSOR(EE) RXBEE_AT_ACCESSOR(ER) RXBEE_AT_ACCESSOR(FN) RXBEE_AT_ACCESSOR(FT) RXBEE_AT_ACCESSOR(GD)
+RXBEE_AT_ACCESSOR(GT) RXBEE_AT_ACCESSOR(HP) RXBEE_AT_ACCESSOR(HS) RXBEE_AT_ACCESSOR(HV) RXBEE_AT_ACCESSOR(IC) RXBEE_AT_ACCESSOR(ID)
+RXBEE_AT_ACCESSOR(IF) RXBEE_AT_ACCESSOR(IR) RXBEE_AT_ACCESSOR(LT) RXBEE_AT_ACCESSOR(M0) RXBEE_AT_ACCESSOR(M1) RXBEE_AT_ACCESSOR(MF)
+RXBEE_AT_ACCESSOR(MR) RXBEE_AT_ACCESSOR(MS) RXBEE_AT_ACCESSOR(MT) RXBEE_AT_ACCESSOR(NB) RXBEE_AT_ACCESSOR(ND) RXBEE_AT_ACCESSOR(NH)
+RXBEE_AT_ACCESSOR(NI) RXBEE_AT_ACCESSOR(NN) RXBEE_AT_ACCESSOR(NO) RXBEE_AT_ACCESSOR(NP) RXBEE_AT_ACCESSOR(NT) RXBEE_AT_ACCESSOR(OS)
+RXBEE_AT_ACCESSOR(OW) RXBEE_AT_ACCESSOR(P0) RXBEE_AT_ACCESSOR(P1) RXBEE_AT_ACCESSOR(P2) RXBEE_AT_ACCESSOR(P3) RXBEE_AT_ACCESSOR(P4)
+RXBEE_AT_ACCESSOR(PD) RXBEE_AT_ACCESSOR(PL) RXBEE_AT_ACCESSOR(PR) RXBEE_AT_ACCESSOR(RO) RXBEE_AT_ACCESSOR(RP) RXBEE_AT_ACCESSOR(RR)
+RXBEE_AT_ACCESSOR(SB) RXBEE_AT_ACCESSOR(SE) RXBEE_AT_ACCESSOR(SH) RXBEE_AT_ACCESSOR(SL) RXBEE_AT_ACCESSOR(SM) RXBEE_AT_ACCESSOR(SN)
+RXBEE_AT_ACCESSOR(SO) RXBEE_AT_ACCESSOR(SP) RXBEE_AT_ACCESSOR(SQ) RXBEE_AT_ACCESSOR(SS) RXBEE_AT_ACCESSOR(ST) RXBEE_AT_ACCESSOR(TO)
+RXBEE_AT_ACCESSOR(TP) RXBEE_AT_ACCESSOR(TR) RXBEE_AT_ACCESSOR(UA) RXBEE_AT_ACCESSOR(VL) RXBEE_AT_ACCESSOR(VR) RXBEE_AT_ACCESSOR(WH)
+
+#undef RXBEE_AT_ACCESSOR
+
 } // namespace RXBee.Response.ATCommand
 
 enum class TransmitDeliveryStatus
@@ -592,7 +631,7 @@ struct RouteInformation
     RouteInformation(ApiFrame& rsp);
     Frame* frame;
     bool extracted;
-    bool trace;
+    bool trace;                 // Trace route, otherwise NACK
     uint32_t timestamp;
     uint8_t ack_timeout_count;
     uint8_t tx_blocked_count;
@@ -633,6 +672,7 @@ struct ReceivePacket
 struct ExplicitReceivePacket
 {
     ExplicitReceivePacket(ApiFrame& rsp);
+    ExplicitReceivePacket(ApiFrame& rsp, std::vector<uint8_t>& buffer);
     Frame* frame;
     bool extracted;
     uint64_t sender_addr;
@@ -656,8 +696,9 @@ struct ExplicitIOSample
     uint8_t number_of_samples;
     uint16_t digital_channel_mask;
     uint8_t analog_channel_mask;
-    uint16_t digital_samples;
-    uint16_t analog_samples[4];
+    uint16_t digital_samples;       // Present when digital_channel_mask is set
+    uint16_t analog_samples[XBEE_IO_ANALOG_CHANNELS];   // 10 bit, enabled channels
+    uint16_t supply_voltage;        // mV, when XBEE_IO_SUPPLY_VOLTAGE is set
 };
 
 enum class DeviceType
@@ -677,14 +718,14 @@ struct NodeID
     uint64_t source_addr;
     uint8_t options;
     uint64_t remote_addr;
-    char identifier[XBEE_AT_NI_IDENT_LEN];
+    char identifier[XBEE_AT_NI_IDENT_LEN + 1];
     uint16_t identifier_len;
     DeviceType type;
     bool pushbutton;
     uint16_t digi_profile_id;
     uint16_t digi_mfr_id;
     bool digi_dd_value_included;
-    uint16_t digi_dd_value;
+    uint32_t digi_dd_value;
     bool rssi_included;
     int8_t rssi;
 };
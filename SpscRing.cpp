@@ -0,0 +1,67 @@
+
+#include "SpscRing.h"
+
+#if RXBEE_MIRRORED_RING && defined(__linux__)
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace RXBee
+{
+
+void SpscRing::Map()
+{
+    long page = sysconf(_SC_PAGESIZE);
+    int fd = -1;
+    uint8_t* base = static_cast<uint8_t*>(MAP_FAILED);
+
+    if ((page > 0) && ((size % page) == 0))
+    {
+        fd = memfd_create("rxbee_rx_ring", 0);
+    }
+
+    if ((fd >= 0) && (ftruncate(fd, size) == 0))
+    {
+        // Reserve both halves, then map the same pages into each
+        base = static_cast<uint8_t*>(mmap(NULL, 2 * size, PROT_NONE,
+                                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    }
+
+    if (base != MAP_FAILED)
+    {
+        void* lower = mmap(base, size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_FIXED, fd, 0);
+        void* upper = mmap(base + size, size,
+                           PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+
+        if ((lower == base) && (upper == base + size))
+        {
+            buff = base;
+            mirrored = true;
+        }
+        else
+        {
+            munmap(base, 2 * size);
+        }
+    }
+
+    // The mappings keep the memory alive
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+void SpscRing::Unmap()
+{
+    if (mirrored)
+    {
+        munmap(buff, 2 * size);
+        buff = storage;
+        mirrored = false;
+    }
+}
+
+} // namespace RXBee
+
+#endif // RXBEE_MIRRORED_RING && __linux__
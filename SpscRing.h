@@ -0,0 +1,197 @@
+#ifndef RXBEE_SPSC_RING_H
+#define RXBEE_SPSC_RING_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "RXBee_Config.h"
+
+#if RXBEE_THREADED
+#include <atomic>
+#endif
+
+#if RXBEE_THREADED
+#define RXBEE_CACHE_ALIGNED alignas(RXBEE_CACHE_LINE_SIZE)
+#else
+#define RXBEE_CACHE_ALIGNED
+#endif
+
+namespace RXBee
+{
+
+// Value written by one thread and read by another. Plain type unless the
+// library is built with RXBEE_THREADED.
+#if RXBEE_THREADED
+template<typename T> using Shared = std::atomic<T>;
+#else
+template<typename T> using Shared = T;
+#endif
+
+// Index of a single producer / single consumer ring. The owning side reads
+// its own index with Load() and publishes it with Release(), the other side
+// reads it with Acquire().
+class RingIndex
+{
+public:
+    RingIndex() : value(0) {}
+
+#if RXBEE_THREADED
+    uint16_t Load() const { return value.load(std::memory_order_relaxed); }
+    uint16_t Acquire() const { return value.load(std::memory_order_acquire); }
+    void Release(uint16_t index) { value.store(index, std::memory_order_release); }
+#else
+    uint16_t Load() const { return value; }
+    uint16_t Acquire() const { return value; }
+    void Release(uint16_t index) { value = index; }
+#endif
+
+private:
+    Shared<uint16_t> value;
+};
+
+// Received bytes waiting in the ring. Bytes crossing the end of the
+// buffer continue in the second segment, which is empty when the ring is
+// mirrored.
+struct RingView
+{
+    const uint8_t* first;
+    uint16_t first_len;
+    const uint8_t* second;
+    uint16_t second_len;
+};
+
+// Receive byte ring. Write() is called by the serial reader (producer),
+// everything else by the thread calling XBeeNetwork::Service (consumer).
+//
+// With RXBEE_MIRRORED_RING on Linux the buffer is mapped twice back to
+// back, so the bytes after the end of the buffer are the bytes at its
+// start and any run of received bytes, and so every frame, is contiguous.
+class SpscRing
+{
+public:
+    // size bytes of storage, at most 32768. With NULL storage the ring
+    // allocates its own unless the mapping succeeds, storage passed in is
+    // unused when the ring is mirrored.
+    SpscRing(uint8_t* storage, uint16_t size)
+        : storage(storage), buff(storage), size(size), owned(false), mirrored(false)
+    {
+#if RXBEE_MIRRORED_RING && defined(__linux__)
+        Map();
+#endif
+        if (!mirrored && (storage == NULL))
+        {
+            this->storage = new uint8_t[size];
+            buff = this->storage;
+            owned = true;
+        }
+    }
+
+    ~SpscRing()
+    {
+#if RXBEE_MIRRORED_RING && defined(__linux__)
+        Unmap();
+#endif
+        if (owned)
+        {
+            delete[] storage;
+        }
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Copies up to len bytes into the ring, returns the number of bytes
+    // accepted. Fewer than len bytes means the ring is full.
+    uint16_t Write(const uint8_t* bytes, uint16_t len)
+    {
+        uint16_t t = tail.Load();
+        uint16_t h = head.Acquire();
+        uint16_t space = (h + size - t - 1) % size;
+        uint16_t n = (len < space) ? len : space;
+        uint16_t first = size - t;
+
+        if (mirrored || (first > n))
+        {
+            first = n;
+        }
+        memcpy(&buff[t], bytes, first);
+        memcpy(&buff[0], &bytes[first], n - first);
+
+        t += n;
+        if (t >= size)
+        {
+            t -= size;
+        }
+        tail.Release(t);
+
+        return n;
+    }
+
+    // Everything received so far, released with Consume()
+    void GetReadView(RingView& view) const
+    {
+        uint16_t h = head.Load();
+        uint16_t t = tail.Acquire();
+
+        view.first = &buff[h];
+        view.second = &buff[0];
+        if (t >= h)
+        {
+            view.first_len = t - h;
+            view.second_len = 0;
+        }
+        else if (mirrored)
+        {
+            view.first_len = size - h + t;
+            view.second_len = 0;
+        }
+        else
+        {
+            view.first_len = size - h;
+            view.second_len = t;
+        }
+    }
+
+    // Releases the oldest n bytes back to the producer
+    void Consume(uint16_t n)
+    {
+        uint16_t h = head.Load() + n;
+        if (h >= size)
+        {
+            h -= size;
+        }
+        head.Release(h);
+    }
+
+    bool IsMirrored() const { return mirrored; }
+
+    uint16_t GetSize() const { return size; }
+
+    uint16_t GetHead() const { return head.Load(); }
+
+    uint16_t GetTail() const { return tail.Acquire(); }
+
+    // Discards everything written so far
+    void Clear() { head.Release(tail.Acquire()); }
+
+private:
+#if RXBEE_MIRRORED_RING && defined(__linux__)
+    // Falls back to storage when the mapping fails, e.g. when size is
+    // not a multiple of the page size
+    void Map();
+    void Unmap();
+#endif
+
+    uint8_t* storage;
+    uint8_t* buff;          // storage, or its mirrored mapping
+    uint16_t size;
+    bool owned;
+    bool mirrored;
+
+    RXBEE_CACHE_ALIGNED RingIndex head;
+    RXBEE_CACHE_ALIGNED RingIndex tail;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_SPSC_RING_H
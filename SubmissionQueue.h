@@ -0,0 +1,61 @@
+#ifndef RXBEE_SUBMISSION_QUEUE_H
+#define RXBEE_SUBMISSION_QUEUE_H
+
+#include <stdint.h>
+
+#include "RXBee_Config.h"
+#include "Transaction.h"
+
+#if RXBEE_THREADED
+#include <atomic>
+
+namespace RXBee
+{
+
+// Lock-free multiple producer / single consumer queue of pended
+// transactions. Any thread may Push(), only the Service thread may PopAll().
+class SubmissionQueue
+{
+public:
+    SubmissionQueue() : top(NULL) {}
+
+    void Push(Transaction* t)
+    {
+        Transaction* old_top = top.load(std::memory_order_relaxed);
+        do
+        {
+            t->submit_next = old_top;
+        }
+        while (!top.compare_exchange_weak(old_top, t,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+    }
+
+    // Takes every submitted transaction, returned oldest first and linked
+    // through submit_next
+    Transaction* PopAll()
+    {
+        Transaction* t = top.exchange(NULL, std::memory_order_acquire);
+        Transaction* fifo = NULL;
+
+        // Pushes are LIFO, reverse to preserve submission order
+        while (t != NULL)
+        {
+            Transaction* next = t->submit_next;
+            t->submit_next = fifo;
+            fifo = t;
+            t = next;
+        }
+
+        return fifo;
+    }
+
+private:
+    std::atomic<Transaction*> top;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_THREADED
+
+#endif // RXBEE_SUBMISSION_QUEUE_H
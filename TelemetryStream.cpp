@@ -0,0 +1,150 @@
+
+#include "TelemetryStream.h"
+#include "Network.h"
+
+namespace RXBee
+{
+
+TelemetryStream::TelemetryStream(XBeeNetwork* network, Address dest, uint8_t stream_id)
+    : net(network), dest_addr(dest), id(stream_id), sequence(0),
+      keyframe_interval(RXBEE_DELTA_KEYFRAME_INTERVAL), since_keyframe(0),
+      has_base(false), resync(false), base_sequence(0)
+{
+    stats.keyframes = 0;
+    stats.deltas = 0;
+    stats.resyncs = 0;
+    stats.record_bytes = 0;
+    stats.sent_bytes = 0;
+}
+
+TelemetryStream::~TelemetryStream()
+{
+    // Records still in flight must not call back into a dead stream
+    for (uint16_t i = 0; i < in_flight.size(); ++i)
+    {
+        in_flight[i].transaction->OnComplete(NULL, NULL);
+    }
+}
+
+void TelemetryStream::SetKeyframeInterval(uint16_t interval)
+{
+    keyframe_interval = interval;
+}
+
+void TelemetryStream::Resync()
+{
+    resync = true;
+}
+
+const TelemetryStream::Stats& TelemetryStream::GetStats() const
+{
+    return stats;
+}
+
+Transaction* TelemetryStream::Send(const uint8_t* record, uint16_t n)
+{
+    Transaction* t = NULL;
+
+    if (n <= RXBEE_DELTA_MAX_RECORD)
+    {
+        t = SendRecord(record, n);
+    }
+
+    return t;
+}
+
+Transaction* TelemetryStream::SendRecord(const uint8_t* record, uint16_t n)
+{
+    std::vector<uint8_t> body;
+    std::vector<uint8_t> delta;
+    Transaction* t = NULL;
+
+    sequence++;
+    body.reserve(3 + n);
+    body.push_back(id);
+    body.push_back(sequence);
+
+    // The receiver keeps the last RXBEE_DELTA_HISTORY records, the base
+    // must not have been pushed out by the records in flight
+    bool keyframe = !has_base || resync || (base.size() != n) || (base_sequence == sequence) ||
+                    (in_flight.size() >= RXBEE_DELTA_HISTORY) ||
+                    ((keyframe_interval > 0) && (since_keyframe >= keyframe_interval));
+
+    if (!keyframe)
+    {
+        PayloadCodec::EncodeDelta(&base[0], record, n, delta);
+        keyframe = (delta.size() >= n);
+    }
+
+    if (keyframe)
+    {
+        body.push_back(sequence);
+        body.insert(body.end(), record, record + n);
+        since_keyframe = 0;
+        resync = false;
+        stats.keyframes++;
+    }
+    else
+    {
+        body.push_back(base_sequence);
+        body.insert(body.end(), delta.begin(), delta.end());
+        since_keyframe++;
+        stats.deltas++;
+    }
+
+    stats.record_bytes += n;
+    stats.sent_bytes += body.size();
+
+    t = net->BeginTransaction(dest_addr);
+    if (t != NULL)
+    {
+        t = t->TransmitEnvelope(RXBEE_ENVELOPE_DELTA, &body[0], body.size(), true,
+                                HandleComplete, this);
+    }
+
+    if (t != NULL)
+    {
+        // Completion is reported by Service, after the record is recorded
+        InFlight sent;
+        sent.transaction = t;
+        sent.sequence = sequence;
+        sent.record.assign(record, record + n);
+        in_flight.push_back(sent);
+    }
+
+    return t;
+}
+
+void TelemetryStream::HandleComplete(Transaction* transaction, void* context)
+{
+    TelemetryStream* stream = static_cast<TelemetryStream*>(context);
+
+    if (stream != NULL)
+    {
+        for (uint16_t i = 0; i < stream->in_flight.size(); ++i)
+        {
+            InFlight& sent = stream->in_flight[i];
+            if (sent.transaction == transaction)
+            {
+                if (transaction->GetError() != Transaction::Error::NONE)
+                {
+                    // The receiver may have lost the record or its base
+                    stream->resync = true;
+                    stream->stats.resyncs++;
+                }
+                else if (!stream->has_base ||
+                         (static_cast<int8_t>(sent.sequence - stream->base_sequence) > 0))
+                {
+                    stream->base.swap(sent.record);
+                    stream->base_sequence = sent.sequence;
+                    stream->has_base = true;
+                }
+
+                stream->in_flight.erase(stream->in_flight.begin() + i);
+                break;
+            }
+        }
+    }
+}
+
+} // namespace RXBee
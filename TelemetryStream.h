@@ -0,0 +1,88 @@
+#ifndef RXBEE_TELEMETRY_STREAM_H
+#define RXBEE_TELEMETRY_STREAM_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "Types.h"
+#include "Transaction.h"
+#include "PayloadCodec.h"
+
+#ifndef RXBEE_DELTA_KEYFRAME_INTERVAL
+    #define RXBEE_DELTA_KEYFRAME_INTERVAL   (30)    // Records between keyframes
+#endif
+
+// Stream ID and sequences precede the record in the envelope body
+#define RXBEE_DELTA_MAX_RECORD  (RXBEE_UNPACK_MAX_SIZE - 3)
+
+namespace RXBee
+{
+
+class XBeeNetwork;
+
+// Sends a fixed layout record, e.g. a sensor struct sent every second, as
+// the changes since the last record the destination acknowledged. Every
+// keyframe interval, after a failed delivery and whenever the record size
+// changes the whole record is sent instead. The receiving network rebuilds
+// the record before OnSerialDataReceived, see PayloadCodec.
+//
+//   TelemetryStream stream(&net, gateway, 1);
+//   stream.Send(reinterpret_cast<const uint8_t*>(&sample), sizeof(sample));
+class TelemetryStream
+{
+public:
+    struct Stats
+    {
+        uint32_t keyframes;
+        uint32_t deltas;
+        uint32_t resyncs;           // Keyframes forced by a failed delivery
+        uint32_t record_bytes;      // Bytes passed to Send
+        uint32_t sent_bytes;        // Stream bytes handed to Transmit
+    };
+
+    TelemetryStream(XBeeNetwork* network, Address dest, uint8_t stream_id);
+    ~TelemetryStream();
+
+    // 0 sends keyframes only to resync
+    void SetKeyframeInterval(uint16_t interval);
+
+    // Returns the transaction carrying the record, complete once the
+    // destination acknowledged it, or NULL when the record is longer than
+    // RXBEE_DELTA_MAX_RECORD. Service thread only, the stream state is
+    // updated by the completion handler.
+    Transaction* Send(const uint8_t* record, uint16_t n);
+
+    // The next record is sent whole
+    void Resync();
+
+    const Stats& GetStats() const;
+
+private:
+    static void HandleComplete(Transaction* transaction, void* context);
+
+    Transaction* SendRecord(const uint8_t* record, uint16_t n);
+
+    struct InFlight
+    {
+        Transaction* transaction;
+        uint8_t sequence;
+        std::vector<uint8_t> record;
+    };
+
+    XBeeNetwork* net;
+    Address dest_addr;
+    uint8_t id;
+    uint8_t sequence;
+    uint16_t keyframe_interval;
+    uint16_t since_keyframe;
+    bool has_base;
+    bool resync;
+    uint8_t base_sequence;
+    std::vector<uint8_t> base;
+    std::vector<InFlight> in_flight;
+    Stats stats;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_TELEMETRY_STREAM_H
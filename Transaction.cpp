@@ -19,12 +19,30 @@ void Transaction::OnComplete(Transaction::CompleteHandler handler, void* context
     }
 }
 
+Transaction* Transaction::Collect(int32_t window_ms, Transaction::ResponseHandler handler, void* context)
+{
+    on_response_handler = handler;
+    on_response_context = context;
+    collect_window = window_ms;
+    retries = 0;
+    return this;
+}
+
 Transaction::Transaction()
     : target_frame_id(0), on_complete_handler(NULL), 
         dest_addr(RXBEE_LOCAL_ADDRESS),
         err(Error::NONE), state(State::FREE),
-        on_complete_context(NULL), prev(NULL), next(NULL), queue_cmds(false),
-        apply_timeout(true), retries(0)
+        on_complete_context(NULL), on_response_handler(NULL),
+        on_response_context(NULL), collect_window(0),
+        tx_radius(XBEE_TX_RADIUS_MAX_HOPS), tx_options(XBEE_TX_DELIVERY_DIGIMESH),
+        prev(NULL), next(NULL), queue_cmds(false),
+        batched(false), retried(false), apply_timeout(true), retries(0)
+#if RXBEE_THREADED
+        , submit_next(NULL), submitted(false)
+#endif
+#if RXBEE_HISTOGRAMS
+        , initialized_at(0), pended_at(0), sent_at(0), sent_api(ApiID::UNKOWN)
+#endif
 {
     
 }
@@ -37,13 +55,30 @@ Transaction::Transaction(const Transaction& t)
     err = t.err;
     state = t.state;
     on_complete_context = t.on_complete_context;
+    on_response_handler = t.on_response_handler;
+    on_response_context = t.on_response_context;
+    collect_window = t.collect_window;
+    tx_radius = t.tx_radius;
+    tx_options = t.tx_options;
     dest_addr = t.dest_addr;
     prev = t.prev;
     next = t.next;
     queue_cmds = t.queue_cmds;
+    batched = t.batched;
+    retried = t.retried;
     apply_timeout = t.apply_timeout;
     timeout_remaining = t.timeout_remaining;
     retries = t.retries;
+#if RXBEE_THREADED
+    submit_next = NULL;
+    submitted = false;
+#endif
+#if RXBEE_HISTOGRAMS
+    initialized_at = t.initialized_at;
+    pended_at = t.pended_at;
+    sent_at = t.sent_at;
+    sent_api = t.sent_api;
+#endif
 }
 
 Transaction::~Transaction()
@@ -59,13 +94,31 @@ Transaction& Transaction::operator=(Transaction& t)
     err = t.err;
     state = t.state;
     on_complete_context = t.on_complete_context;
+    on_response_handler = t.on_response_handler;
+    on_response_context = t.on_response_context;
+    collect_window = t.collect_window;
+    tx_radius = t.tx_radius;
+    tx_options = t.tx_options;
     dest_addr = t.dest_addr;
     prev = t.prev;
     next = t.next;
     queue_cmds = t.queue_cmds;
+    batched = t.batched;
+    retried = t.retried;
     apply_timeout = t.apply_timeout;
     timeout_remaining = t.timeout_remaining;
     retries = t.retries;
+#if RXBEE_THREADED
+    submit_next = NULL;
+    submitted = false;
+#endif
+#if RXBEE_HISTOGRAMS
+    initialized_at = t.initialized_at;
+    pended_at = t.pended_at;
+    sent_at = t.sent_at;
+    sent_api = t.sent_api;
+#endif
+    return *this;
 }
 
 void Transaction::Initialize(Address destination, XBeeNetwork* network)
@@ -73,6 +126,11 @@ void Transaction::Initialize(Address destination, XBeeNetwork* network)
     target_frame_id = 0;
     on_complete_handler = NULL;
     on_complete_context = NULL;
+    on_response_handler = NULL;
+    on_response_context = NULL;
+    collect_window = 0;
+    tx_radius = XBEE_TX_RADIUS_MAX_HOPS;
+    tx_options = XBEE_TX_DELIVERY_DIGIMESH;
     dest_addr = destination;
     err = Error::NONE;
     current_frame.Clear();
@@ -80,9 +138,23 @@ void Transaction::Initialize(Address destination, XBeeNetwork* network)
     net = network;
     prev = NULL;
     next = NULL;
+    queue_cmds = false;
+    batched = false;
+    retried = false;
     apply_timeout = true;
-    timeout_remaining = RXBEE_TRANSACTION_TIMEOUT;
-    retries = RXBEE_TRANSACTION_RETRY;
+    timeout_remaining = (network != NULL) ? network->limits.transaction_timeout
+                                          : RXBEE_TRANSACTION_TIMEOUT;
+    retries = (network != NULL) ? network->limits.transaction_retry : RXBEE_TRANSACTION_RETRY;
+#if RXBEE_THREADED
+    submit_next = NULL;
+    submitted = false;
+#endif
+#if RXBEE_HISTOGRAMS
+    initialized_at = (network != NULL) ? network->GetLatencyTime() : 0;
+    pended_at = initialized_at;
+    sent_at = initialized_at;
+    sent_api = ApiID::UNKOWN;
+#endif
 }
     
 Frame* Transaction::GetFrame()
@@ -110,37 +182,73 @@ Transaction::State Transaction::GetState() const
     return state;
 }
     
+bool Transaction::IsCollecting() const
+{
+    return collect_window > 0;
+}
+
+bool Transaction::IsInFlight() const
+{
+    return (state == State::SENT) && !IsCollecting();
+}
+
 bool Transaction::TryComplete(Frame& frame)
 {
     bool completed = false;
-#if RXBEE_DEBUG
-        char buffer[30];
-#endif
     
-    if ((current_frame.GetApiID() == ApiID::TRANSMIT_REQUEST) && 
+    if (((current_frame.GetApiID() == ApiID::TRANSMIT_REQUEST) ||
+         (current_frame.GetApiID() == ApiID::EXPLICIT_ADDRESSING_COMMAND)) && 
         (frame.GetApiID() == ApiID::TRANSMIT_STATUS))
     {
         Response::ApiFrame api_frame = Response::ApiFrame(&frame);
         Response::TransmitStatus status = Response::TransmitStatus(api_frame);
+        if (status.extracted && (frame.GetFrameID() == target_frame_id) &&
+            (status.delivery_status != Response::TransmitDeliveryStatus::SUCCESS))
+        {
+            SetError(Error::TX_DELIVERY_FAILED);
+        }
+        
         if (status.extracted)
         {
-#if RXBEE_DEBUG
-            sprintf(buffer, "Transaction status = %d, id => %d", status.delivery_status, target_frame_id);
-            net->Print(buffer);
-#endif
+            RXBEE_LOG_DEBUG(net, LogID::TRANSACTION_STATUS,
+                            static_cast<uint8_t>(status.delivery_status), target_frame_id);
         }
     }
     
-    if (frame.GetFrameID() == target_frame_id)
+    if ((frame.GetFrameID() == target_frame_id) && (collect_window > 0))
+    {
+        // Collecting, stay open until the window closes
+        if (on_response_handler != NULL)
+        {
+            on_response_handler(this, frame, on_response_context);
+        }
+        completed = true;
+    }
+    else if (frame.GetFrameID() == target_frame_id)
     {
         current_frame.Clear();
         current_frame = frame;
         
-#if RXBEE_DEBUG
-        sprintf(buffer, "Transaction completed, id => %d", target_frame_id);
-        net->Print(buffer);
-#endif
-        Complete();
+        Response::ApiFrame api_frame(&current_frame);
+        Response::ATCommand::Response at_rsp(api_frame);
+        if (at_rsp.extracted && ((err == Error::NONE) || !batched))
+        {
+            // Keeps the first failure a batch reported on its last command
+            SetError(ToError(at_rsp.status));
+        }
+        
+        RXBEE_LOG_DEBUG(net, LogID::TRANSACTION_COMPLETED, target_frame_id);
+        if (at_rsp.extracted && (err != Error::NONE))
+        {
+            // A failed command ends the rest of its chain
+            CountCompletion();
+            CompleteWithError(err);
+        }
+        else
+        {
+            Complete();
+        }
+        completed = true;
     }
     
     return completed;
@@ -162,6 +270,33 @@ void Transaction::Sent(uint16_t frame_id)
 {
     target_frame_id = frame_id;
     state = State::SENT;
+#if RXBEE_HISTOGRAMS
+    sent_at = net->GetLatencyTime();
+    sent_api = current_frame.GetApiID();
+#endif
+    
+    if (collect_window > 0)
+    {
+        timeout_remaining = collect_window;
+    }
+}
+
+void Transaction::Redirect(Address destination)
+{
+    Transaction* t = this;
+    while (t != NULL)
+    {
+        ApiID api_id = t->current_frame.GetApiID();
+        if ((api_id == ApiID::TRANSMIT_REQUEST) ||
+            (api_id == ApiID::EXPLICIT_ADDRESSING_COMMAND) ||
+            (api_id == ApiID::REMOTE_AT_COMMAND))
+        {
+            // Destination follows the frame ID in all addressed frames
+            t->current_frame.SetField(XBEE_FRAME_API_CONTENT_INDEX, destination);
+        }
+        t->dest_addr = destination;
+        t = t->next;
+    }
 }
 
 void Transaction::CompleteWithError(Transaction::Error error)
@@ -184,6 +319,7 @@ void Transaction::CompleteWithError(Transaction::Error error)
 void Transaction::Complete()
 {
     state = State::COMPLETE;
+    CountCompletion();
     
     if (on_complete_handler != NULL)
     {
@@ -194,7 +330,18 @@ void Transaction::Complete()
 }
 
 
-void Transaction::Chain(Transaction* chain)
+void Transaction::CountCompletion()
+{
+    if (net != NULL)
+    {
+        net->metrics.transactions_completed.Increment();
+#if RXBEE_HISTOGRAMS
+        net->RecordLatency(this);
+#endif
+    }
+}
+
+Transaction* Transaction::Link(Transaction* chain)
 {
     Transaction* t = this;
     while (t->next != NULL)
@@ -207,8 +354,26 @@ void Transaction::Chain(Transaction* chain)
     {
         chain->prev = t;
     }
+    return t;
+}
+
+void Transaction::Chain(Transaction* chain)
+{
+    Transaction* t = Link(chain);
     t->OnComplete(HandleChainComplete, on_complete_context);
 }
+
+void Transaction::Batch(Transaction* batch)
+{
+    Transaction* t = Link(batch);
+    
+    if (batch != NULL)
+    {
+        batch->batched = true;
+        batch->queue_cmds = true;
+    }
+    t->OnComplete(HandleBatchComplete, on_complete_context);
+}
     
 Transaction* Transaction::Pend()
 {
@@ -223,7 +388,25 @@ Transaction* Transaction::Pend()
     {
         t->next->state = State::FRAMED;
     }
-    t->timeout_remaining = 300;
+    t->timeout_remaining = (net != NULL) ? net->limits.first_attempt_timeout
+                                         : RXBEE_FIRST_ATTEMPT_TIMEOUT;
+    
+#if RXBEE_HISTOGRAMS
+    if (net != NULL)
+    {
+        uint32_t now = net->GetLatencyTime();
+        for (Transaction* link = t; link != NULL; link = link->next)
+        {
+            link->pended_at = now;
+        }
+    }
+#endif
+    
+    if (net != NULL)
+    {
+        // Hand the chain over to the Service thread
+        net->Submit(t);
+    }
     
     return this;
 }
@@ -248,6 +431,12 @@ bool Transaction::HasTimeoutExpired(int32_t elapsed)
         {
             timeout_remaining = 0;
             state = State::TIMEOUT;
+            
+            if (collect_window > 0)
+            {
+                // End of the collection window is not an error
+                Complete();
+            }
         }
     }
     
@@ -262,6 +451,9 @@ bool Transaction::Retry()
     {
         retries--;
         state = State::PENDING;
+        timeout_remaining = (net != NULL) ? net->limits.transaction_timeout
+                                          : RXBEE_TRANSACTION_TIMEOUT;
+        retried = true;
         result = true;
     }
     
@@ -285,6 +477,47 @@ void Transaction::HandleChainComplete(Transaction* transaction,
     }
 }
 
+void Transaction::HandleBatchComplete(Transaction* transaction, void*)
+{
+    if ((transaction != NULL) && (transaction->err != Error::NONE))
+    {
+        // Report the first failure of the batch on its last command
+        Transaction* t = transaction;
+        while ((t->next != NULL) && t->next->batched)
+        {
+            t = t->next;
+        }
+        
+        if ((t != transaction) && (t->err == Error::NONE))
+        {
+            t->SetError(transaction->err);
+        }
+    }
+}
+
+Transaction::Error Transaction::ToError(Response::ATCommand::Status status)
+{
+    Error error = Error::NONE;
+    switch (status)
+    {
+        case Response::ATCommand::Status::OK:
+            break;
+        case Response::ATCommand::Status::INVALID_COMMAND:
+            error = Error::AT_CMD_INVALID_COMMAND;
+            break;
+        case Response::ATCommand::Status::INVALID_PARAMETER:
+            error = Error::AT_CMD_INVALID_PARAMETER;
+            break;
+        case Response::ATCommand::Status::TX_FAILURE:
+            error = Error::AT_CMD_TX_FAILURE;
+            break;
+        default:
+            error = Error::AT_CMD_ERROR;
+            break;
+    }
+    return error;
+}
+
 Transaction* Transaction::WritePreambleID(uint8_t id) 
 { 
     Transaction* t = GetNextCmdTransaction();
@@ -359,7 +592,9 @@ Transaction* Transaction::NetworkDiscover()
 {
     Transaction* t = GetNextCmdTransaction();
     t->GetFrame()->AddField(XBEE_CMD_ND);  
-    t->apply_timeout = false;
+    
+    // Every node answers with the same frame ID until the radio's NT expires
+    t->Collect(RXBEE_DISCOVERY_TIMEOUT, NULL, NULL);
     return t;   
 }
 
@@ -391,6 +626,13 @@ Transaction* Transaction::WriteMaxPacketPayloadBytes(uint16_t max_rf_payload_byt
     return t;   
 }
 
+Transaction* Transaction::ReadParameter(const char* cmd)
+{
+    Transaction* t = GetNextCmdTransaction();
+    t->GetFrame()->AddField(cmd);
+    return t;
+}
+
 Transaction* Transaction::BeginCommandQueue() 
 { 
     queue_cmds = true; 
@@ -399,7 +641,11 @@ Transaction* Transaction::BeginCommandQueue()
 
 Transaction* Transaction::EndCommandQueue()
 { 
-    Transaction* t = GetNextCmdTransaction();
+    // Applies the queued commands once they all succeeded, a failure
+    // ends the chain before it (see HandleBatchComplete)
+    queue_cmds = false;
+    Transaction* t = GetNextTransaction();
+    t->InitializeCommandFrame(false, true);
     t->GetFrame()->AddField(XBEE_CMD_AC); 
     return t; 
 } 
@@ -416,7 +662,17 @@ Transaction* Transaction::GetNextTransaction()
     else if (net != NULL)
     {
         t = net->BeginTransaction(dest_addr);
-        Chain(t);       
+        t->tx_radius = tx_radius;
+        t->tx_options = tx_options;
+        
+        if (queue_cmds)
+        {
+            Batch(t);
+        }
+        else
+        {
+            Chain(t);
+        }
     }
     
     t->state = State::FRAMED;
@@ -431,88 +687,231 @@ Transaction* Transaction::GetNextCmdTransaction()
     
     if (t != NULL)
     {
-        ApiID frame_id = ApiID::AT_COMMAND;
+        t->InitializeCommandFrame(queue_cmds, !queue_cmds);
+    }
+    
+    return t;
+}
 
-        if (dest_addr != 0)
-        {
-            frame_id = ApiID::REMOTE_AT_COMMAND;
+void Transaction::InitializeCommandFrame(bool queue, bool apply)
+{
+    ApiID frame_id = ApiID::AT_COMMAND;
+
+    if (dest_addr != 0)
+    {
+        frame_id = ApiID::REMOTE_AT_COMMAND;
+    }
+    else if (queue)
+    {
+        frame_id = ApiID::AT_QUEUE_COMMAND;
+    }
+
+    current_frame.Initialize(frame_id, net->GetApiMode());
+
+    if (dest_addr != 0)
+    {
+        // Remote changes are held until AC unless applied right away
+        current_frame.AddFields(dest_addr,
+                                static_cast<uint16_t>(0xFFFE),
+                                static_cast<uint8_t>(apply ? XBEE_REMOTE_AT_APPLY_CHANGES : 0));
+    }
+}
+
+void Transaction::InitializeTransmitFrame()
+{
+    current_frame.Initialize(ApiID::TRANSMIT_REQUEST, net->GetApiMode());
+    current_frame.AddFields(dest_addr,
+                            static_cast<uint16_t>(0xFFFE), // Reserved
+                            tx_radius,
+                            tx_options);
+}
+
+void Transaction::InitializeExplicitFrame(uint8_t source_endpoint, uint8_t destination_endpoint,
+                                          uint16_t cluster, uint16_t profile)
+{
+    current_frame.Initialize(ApiID::EXPLICIT_ADDRESSING_COMMAND, net->GetApiMode());
+    current_frame.AddFields(dest_addr,
+                            static_cast<uint16_t>(0xFFFE), // Reserved
+                            source_endpoint,
+                            destination_endpoint,
+                            cluster,
+                            profile,
+                            tx_radius,
+                            tx_options);
+}
+
+Transaction* Transaction::SetTransmitOptions(uint8_t radius, uint8_t options)
+{
+    tx_radius = radius;
+    tx_options = options;
+    return this;
+}
+
+Transaction* Transaction::Transmit(const uint8_t* buffer, uint16_t n, bool compress,
+                                   Transaction::CompleteHandler handler, void* context)
+{
+    return TransmitEnvelope(0, buffer, n, compress, handler, context);
+}
+
+Transaction* Transaction::TransmitExplicit(uint8_t source_endpoint, uint8_t destination_endpoint,
+                                           uint16_t cluster, uint16_t profile,
+                                           const uint8_t* buffer, uint16_t n,
+                                           Transaction::CompleteHandler handler, void* context)
+{
+    Transaction* t = NULL;
+    uint16_t offset = 0;
+    
+    // Sent as is, the receiving service owns the payload format
+    do
+    {
+        uint16_t chunk = net->FitPayload(NULL, 0, &buffer[offset], n - offset);
+        t = GetNextTransaction();
+        t->InitializeExplicitFrame(source_endpoint, destination_endpoint, cluster, profile);
+        t->GetFrame()->AddData(&buffer[offset], chunk);
+        offset += chunk;
+    } while (offset < n);
+    
+    return PendWith(t, handler, context);
+}
 
+Transaction* Transaction::TransmitEnvelope(uint8_t flags, const uint8_t* buffer, uint16_t n, bool compress,
+                                           Transaction::CompleteHandler handler, void* context)
+{
+    Transaction* t = NULL;
+    std::vector<uint8_t> packed;
+    std::vector<uint16_t> chunks;
+    const uint8_t* original = buffer;
+    uint16_t original_n = n;
+    bool enveloped = (flags != 0);
+    
+    // The receiver drops messages expanding past its limit
+    if (compress && (n <= RXBEE_UNPACK_MAX_SIZE) && net->codec.IsCompressing())
+    {
+        if (net->codec.Compress(buffer, n, packed))
+        {
+            flags |= RXBEE_ENVELOPE_COMPRESSED;
+            buffer = &packed[0];
+            n = packed.size();
+            enveloped = true;
         }
-        else if (queue_cmds)
+    }
+    
+    if (!enveloped && net->codec.IsCompressing() && (n > 0))
+    {
+        // The receiver unpacks, keep data that looks like an envelope
+        // or needs fragments intact
+        enveloped = ((buffer[0] & RXBEE_ENVELOPE_HEADER_MASK) == RXBEE_ENVELOPE_HEADER) ||
+                    (net->FitPayload(NULL, 0, buffer, n) < n);
+    }
+    
+    uint8_t header[4];
+    header[0] = RXBEE_ENVELOPE_HEADER | flags | RXBEE_ENVELOPE_FRAGMENT;
+    header[2] = static_cast<uint8_t>(n >> 8);
+    header[3] = static_cast<uint8_t>(n & 0xFF);
+    
+    if (enveloped && (net->FitPayload(header, 1, buffer, n) < n))
+    {
+        // Fragment sizes first, the receiver reassembles a limited message
+        // from a limited number of fragments
+        uint16_t offset = 0;
+        
+        while ((offset < n) && (n <= RXBEE_UNPACK_MAX_SIZE) &&
+               (chunks.size() < RXBEE_ENVELOPE_MAX_FRAGMENTS))
         {
-            frame_id = ApiID::AT_QUEUE_COMMAND;
+            header[1] = static_cast<uint8_t>(chunks.size());
+            chunks.push_back(net->FitPayload(header, chunks.empty() ? 4 : 2,
+                                             &buffer[offset], n - offset));
+            offset += chunks.back();
         }
-
-        Frame* f = t->GetFrame();
-        f->Initialize(frame_id, net->GetApiMode());
-
-        if (dest_addr != 0)
+        
+        if (offset < n)
         {
-            f->AddFields(dest_addr,
-                         static_cast<uint16_t>(0xFFFE),
-                         static_cast<uint8_t>(0));
+            enveloped = false;
+            buffer = original;
+            n = original_n;
         }
     }
     
+    if (!enveloped)
+    {
+        t = TransmitPacket(buffer, n, handler, context);
+    }
+    else
+    {
+        if (chunks.empty())
+        {
+            header[0] &= ~RXBEE_ENVELOPE_FRAGMENT;
+            t = GetNextTransaction();
+            t->InitializeTransmitFrame();
+            t->GetFrame()->AddData(header, 1);
+            t->GetFrame()->AddData(buffer, n);
+        }
+        else
+        {
+            uint16_t offset = 0;
+            
+            for (uint16_t index = 0; index < chunks.size(); ++index)
+            {
+                header[1] = static_cast<uint8_t>(index);
+                t = GetNextTransaction();
+                t->InitializeTransmitFrame();
+                t->GetFrame()->AddData(header, (index == 0) ? 4 : 2);
+                t->GetFrame()->AddData(&buffer[offset], chunks[index]);
+                offset += chunks[index];
+            }
+        }
+        
+        PendWith(t, handler, context);
+    }
+    
     return t;
 }
 
-Transaction* Transaction::Transmit(const uint8_t* buffer, uint16_t n)
+Transaction* Transaction::TransmitPacket(const uint8_t* buffer, uint16_t n,
+                                         Transaction::CompleteHandler handler, void* context)
 {
     Transaction* t = GetNextTransaction(); 
 
     if (t != NULL)
     {
         Frame* f = t->GetFrame();
-        ApiMode api_mode = net->GetApiMode();
-        f->Initialize(ApiID::TRANSMIT_REQUEST, api_mode);
-
-        f->AddFields(dest_addr,
-                     static_cast<uint16_t>(0xFFFE), // Reserved
-                     static_cast<uint8_t>(0),       // Max hops on broadcast
-                     static_cast<uint8_t>(0xC0));   // Delivery method = DigiMesh
+        t->InitializeTransmitFrame();
 
-        uint16_t packet_max_payload_bytes = net->GetMaxPacketPayloadBytes();
-        
-        // If API mode is escaped, reduce max packet size by the number of characters that will be escaped
-        if (api_mode == ApiMode::ESCAPED)
-        {
-            // Reduce max payload byte by 3 for the worst case of escaping length and checksum bytes
-            packet_max_payload_bytes -= 3;
-            
-            for(uint16_t i = 1; i < n; ++i)
-            {
-                // Reduce max payload size by number of escaped characters
-                if ((buffer[i] == XBEE_PACKET_START) ||
-                    (buffer[i] == XBEE_ESCAPE_BYTE) ||
-                    (buffer[i] == XBEE_XON) ||
-                    (buffer[i] == XBEE_XOFF))
-                {
-                    --packet_max_payload_bytes;
-                }
-            }
-        }
+        uint16_t packet_max_payload_bytes = net->FitPayload(NULL, 0, buffer, n);
         
         if (n > packet_max_payload_bytes)
         {
             // Transmit up to max payload bytes
             f->AddData(buffer, packet_max_payload_bytes);
 
-            // Chain next section of data
+            // Chain next section of data, the last link reports the whole
 
-            Transmit(&buffer[packet_max_payload_bytes], n - packet_max_payload_bytes);
+            t = TransmitPacket(&buffer[packet_max_payload_bytes], n - packet_max_payload_bytes,
+                               handler, context);
         }
         else
         {
             // Transmit entire data
             f->AddData(buffer, n);
 
-            Pend();
+            PendWith(t, handler, context);
         }
     }
     
     return t;
 }
 
+Transaction* Transaction::PendWith(Transaction* last, Transaction::CompleteHandler handler,
+                                   void* context)
+{
+    if ((last != NULL) && (handler != NULL))
+    {
+        last->OnComplete(handler, context);
+    }
+    Pend();
+    
+    return last;
+}
+
 
 } // namespace RXBee
\ No newline at end of file
@@ -7,6 +7,19 @@
 #include <cstdint>
 #include "Frame.h"
 #include "Types.h"
+#include "SpecificResponses.h"
+
+#define XBEE_REMOTE_AT_APPLY_CHANGES    (0x02)
+
+// Transmit request options, one delivery method plus any option bits
+#define XBEE_TX_OPTION_DISABLE_ACK      (0x01)
+#define XBEE_TX_OPTION_DISABLE_RD       (0x02)  // No route discovery
+#define XBEE_TX_OPTION_NACK             (0x04)  // Route trace on failure only
+#define XBEE_TX_OPTION_TRACE_ROUTE      (0x08)
+#define XBEE_TX_DELIVERY_POINT_MULTIPOINT (0x40)
+#define XBEE_TX_DELIVERY_REPEATER       (0x80)  // Directed broadcast
+#define XBEE_TX_DELIVERY_DIGIMESH       (0xC0)
+#define XBEE_TX_RADIUS_MAX_HOPS         (0x00)  // Broadcast radius, 0 is NH
 
 namespace RXBee
 {
@@ -27,7 +40,8 @@ public:
         AT_CMD_ERROR,
         AT_CMD_INVALID_COMMAND,
         AT_CMD_INVALID_PARAMETER,
-        AT_CMD_TX_FAILURE
+        AT_CMD_TX_FAILURE,
+        TX_DELIVERY_FAILED
     };
     
     enum class Action
@@ -48,8 +62,17 @@ public:
     typedef void (*CompleteHandler)(Transaction* transaction,
                                     void* context);   
     
+    typedef void (*ResponseHandler)(Transaction* transaction, Frame& frame,
+                                    void* context);
+    
     void OnComplete(CompleteHandler handler, void* context);
     
+    // Keeps the transaction open for window_ms once sent and reports every
+    // response carrying its frame ID, e.g. each node answering a broadcast
+    // remote AT command. Completes without error when the window closes.
+    // The handler may be NULL when responses are handled elsewhere.
+    Transaction* Collect(int32_t window_ms, ResponseHandler handler, void* context);
+    
     Frame* GetFrame();
     
     Error GetError() const;
@@ -81,13 +104,57 @@ public:
     Transaction* ReadMaxPacketPayloadBytes();
     Transaction* WriteMaxPacketPayloadBytes(uint16_t max_rf_payload_bytes);
 
+    // Any AT parameter, cmd is one of the XBEE_CMD_* strings
+    Transaction* ReadParameter(const char* cmd);
+    
+    template<typename T>
+    Transaction* WriteParameter(const char* cmd, const T value)
+    {
+        Transaction* t = GetNextCmdTransaction();
+        t->GetFrame()->AddFields(cmd, value);
+        return t;
+    }
+    
+    // Commands between BeginCommandQueue and EndCommandQueue are queued on
+    // the radio (AT_QUEUE_COMMAND, or REMOTE_AT_COMMAND without the apply
+    // option) and sent in one burst rather than waiting for each response.
+    // AC follows once they all succeeded, otherwise the transaction
+    // returned by EndCommandQueue fails with the first error of the batch.
     Transaction* BeginCommandQueue();
 
     Transaction* EndCommandQueue();
     
     
-    Transaction* Transmit(const uint8_t* buffer, uint16_t n);
-    
+    // Compressed first when the network has compression enabled, pass
+    // compress = false for data that will not shrink (already compressed,
+    // encrypted) to save the attempt.
+    //
+    // Transmit and TransmitExplicit pend the chain, handler is registered
+    // on the returned last link before that. Pass it here instead of
+    // calling OnComplete afterwards when built with RXBEE_THREADED.
+    Transaction* Transmit(const uint8_t* buffer, uint16_t n, bool compress = true,
+                          CompleteHandler handler = NULL, void* context = NULL);
+    
+    // Explicit addressing frame (0x11) for a service on the destination,
+    // e.g. a ZDO or Digi cluster. Never compressed or enveloped, data
+    // longer than a packet goes out in consecutive frames.
+    Transaction* TransmitExplicit(uint8_t source_endpoint, uint8_t destination_endpoint,
+                                  uint16_t cluster, uint16_t profile,
+                                  const uint8_t* buffer, uint16_t n,
+                                  CompleteHandler handler = NULL, void* context = NULL);
+    
+    // Radius (broadcast hops) and XBEE_TX_ options for the following
+    // Transmit and TransmitExplicit calls of the chain
+    Transaction* SetTransmitOptions(uint8_t radius, uint8_t options);
+    
+    // Queues the transaction chain for sending. With RXBEE_THREADED the
+    // chain is handed to the Service thread here, so OnComplete must be
+    // registered before Pend() and the chain must not be modified after it.
+    //
+    // Pended transactions belong to the network. Once its completion
+    // handler returns a transaction is free and Service deletes or reuses
+    // it, so pointers to it are only valid until then and, with
+    // RXBEE_THREADED, only on the Service thread after Pend().
     Transaction* Pend();
     
     Transaction* GetNext();
@@ -96,8 +163,13 @@ public:
     
     bool Retry();
     
+    static Error ToError(Response::ATCommand::Status status);
+    
 protected:
     friend class XBeeNetwork;
+    friend class SubmissionQueue;
+    friend class MessageCoalescer;
+    friend class TelemetryStream;
     
     enum class State
     {
@@ -114,8 +186,19 @@ protected:
     
     State GetState() const;
     
+    // Sent with a collect window, see Collect
+    bool IsCollecting() const;
+    
+    // Sent and awaiting a response, which holds back other transactions
+    // to the same destination. Open collect windows (ND, FN) match
+    // responses by frame ID and hold back nothing.
+    bool IsInFlight() const;
+    
     void Sent(uint16_t frame_id);
     
+    // Readdresses this link and the rest of its chain
+    void Redirect(Address destination);
+    
     bool TryComplete(Frame& frame);
     
     void SetError(Error error);
@@ -126,8 +209,37 @@ protected:
     
     void Complete();
     
+    // Counts a response, error responses included
+    void CountCompletion();
+    
     void Chain(Transaction* t);
     
+    void Batch(Transaction* t);
+    
+    Transaction* Link(Transaction* t);
+    
+    void InitializeCommandFrame(bool queue, bool apply);
+    
+    void InitializeTransmitFrame();
+    
+    void InitializeExplicitFrame(uint8_t source_endpoint, uint8_t destination_endpoint,
+                                 uint16_t cluster, uint16_t profile);
+    
+    // Sends buffer in a PayloadCodec envelope with the given flags,
+    // compressing and fragmenting it as needed. Returns the last link,
+    // handler is registered on it before the chain is pended. Messages
+    // the receiver could not expand or reassemble (RXBEE_UNPACK_MAX_SIZE,
+    // RXBEE_ENVELOPE_MAX_FRAGMENTS) go out as plain packets instead, so
+    // callers passing flags keep their messages within those limits.
+    Transaction* TransmitEnvelope(uint8_t flags, const uint8_t* buffer, uint16_t n, bool compress,
+                                  CompleteHandler handler = NULL, void* context = NULL);
+    
+    Transaction* TransmitPacket(const uint8_t* buffer, uint16_t n,
+                                CompleteHandler handler, void* context);
+    
+    // Registers handler on the last link, then pends the chain
+    Transaction* PendWith(Transaction* last, CompleteHandler handler, void* context);
+    
     XBeeNetwork* net;
     
     Transaction* GetNextTransaction();    
@@ -135,6 +247,7 @@ protected:
     
 private:
     static void HandleChainComplete(Transaction* transaction, void* context);
+    static void HandleBatchComplete(Transaction* transaction, void* context);
     Frame current_frame;
     uint16_t target_frame_id;
     CompleteHandler on_complete_handler;
@@ -142,12 +255,30 @@ private:
     Error err;
     State state;
     void* on_complete_context;
+    ResponseHandler on_response_handler;
+    void* on_response_context;
+    int32_t collect_window;
+    uint8_t tx_radius;
+    uint8_t tx_options;
     bool queue_cmds;
+    bool batched;
+    bool retried;       // Resent after a timeout, outside its burst
     Transaction* prev;
     Transaction* next;
     bool apply_timeout;
     int32_t timeout_remaining;
     int16_t retries;
+#if RXBEE_THREADED
+    Transaction* submit_next;
+    bool submitted;
+#endif
+#if RXBEE_HISTOGRAMS
+    // Latency clock at each state, see XBeeNetwork::SetLatencyClock
+    uint32_t initialized_at;
+    uint32_t pended_at;
+    uint32_t sent_at;
+    ApiID sent_api;         // UNKOWN until sent, the frame is replaced by the response
+#endif
 };
     
 } // namespace RXBee
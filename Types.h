@@ -14,6 +14,11 @@ namespace RXBee
 #define XBEE_BROADCAST_ADDRESS  (0x000000000000FFFF)
 #define RXBEE_LOCAL_ADDRESS     (0x0000000000000000) 
 
+// Destination of a transaction addressed by node identifier whose address
+// is still being looked up, the low word identifies the lookup
+#define RXBEE_UNRESOLVED_ADDRESS        (0xFFFFFFFF00000000)
+#define RXBEE_UNRESOLVED_ADDRESS_MASK   (0xFFFFFFFF00000000)
+
 typedef uint64_t Address;
    
 enum class ApiID : uint8_t 
@@ -0,0 +1,236 @@
+
+#include <string.h>
+
+#include "WireCapture.h"
+
+#define RXBEE_CAPTURE_HEADER_SIZE   (6)     // Time, length
+#define RXBEE_CAPTURE_MASK          (RXBEE_CAPTURE_RING_SIZE - 1)
+
+namespace RXBee
+{
+
+static_assert((RXBEE_CAPTURE_RING_SIZE & RXBEE_CAPTURE_MASK) == 0,
+              "RXBEE_CAPTURE_RING_SIZE must be a power of two");
+static_assert(RXBEE_CAPTURE_RING_SIZE <= 32768, "RXBEE_CAPTURE_RING_SIZE must be at most 32768");
+
+WireCapture::Ring::Ring()
+{
+
+}
+
+void WireCapture::Ring::CopyIn(uint16_t index, const uint8_t* data, uint16_t len)
+{
+    uint16_t start = index & RXBEE_CAPTURE_MASK;
+    uint16_t first = RXBEE_CAPTURE_RING_SIZE - start;
+
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(&buff[start], data, first);
+    memcpy(&buff[0], data + first, len - first);
+}
+
+void WireCapture::Ring::CopyOut(uint16_t index, uint8_t* data, uint16_t len) const
+{
+    uint16_t start = index & RXBEE_CAPTURE_MASK;
+    uint16_t first = RXBEE_CAPTURE_RING_SIZE - start;
+
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(data, &buff[start], first);
+    memcpy(data + first, &buff[0], len - first);
+}
+
+bool WireCapture::Ring::Write(uint32_t time, const uint8_t* data, uint16_t len)
+{
+    bool result = false;
+    uint16_t t = tail.Load();
+    uint16_t used = t - head.Acquire();
+
+    if (static_cast<uint32_t>(used) + RXBEE_CAPTURE_HEADER_SIZE + len <= RXBEE_CAPTURE_RING_SIZE)
+    {
+        uint8_t header[RXBEE_CAPTURE_HEADER_SIZE];
+        memcpy(&header[0], &time, sizeof(time));
+        memcpy(&header[4], &len, sizeof(len));
+
+        CopyIn(t, header, RXBEE_CAPTURE_HEADER_SIZE);
+        CopyIn(t + RXBEE_CAPTURE_HEADER_SIZE, data, len);
+        tail.Release(t + RXBEE_CAPTURE_HEADER_SIZE + len);
+        result = true;
+    }
+    else
+    {
+        dropped.Increment();
+    }
+
+    return result;
+}
+
+bool WireCapture::Ring::Peek(uint32_t& time, uint16_t& len) const
+{
+    bool result = false;
+    uint16_t h = head.Load();
+
+    if (tail.Acquire() != h)
+    {
+        uint8_t header[RXBEE_CAPTURE_HEADER_SIZE];
+        CopyOut(h, header, RXBEE_CAPTURE_HEADER_SIZE);
+        memcpy(&time, &header[0], sizeof(time));
+        memcpy(&len, &header[4], sizeof(len));
+        result = true;
+    }
+
+    return result;
+}
+
+void WireCapture::Ring::Read(std::vector<uint8_t>& out)
+{
+    uint32_t time = 0;
+    uint16_t len = 0;
+
+    if (Peek(time, len))
+    {
+        uint16_t h = head.Load();
+        size_t start = out.size();
+
+        out.resize(start + len);
+        if (len > 0)
+        {
+            CopyOut(h + RXBEE_CAPTURE_HEADER_SIZE, &out[start], len);
+        }
+        head.Release(h + RXBEE_CAPTURE_HEADER_SIZE + len);
+    }
+}
+
+uint32_t WireCapture::Ring::GetDropped() const
+{
+    return dropped.Get();
+}
+
+WireCapture::WireCapture(Clock clock) :
+    clock(clock),
+    format(Format::PCAP),
+    last_time(0),
+    timed(false)
+{
+
+}
+
+void WireCapture::SetFormat(Format format)
+{
+    this->format = format;
+}
+
+void WireCapture::Record(uint8_t direction, const uint8_t* data, uint16_t len)
+{
+    uint32_t time = (clock != NULL) ? clock() : 0;
+    rings[direction & 1].Write(time, data, len);
+}
+
+uint32_t WireCapture::GetDropped(uint8_t direction) const
+{
+    return rings[direction & 1].GetDropped();
+}
+
+static void AppendLittle(std::vector<uint8_t>& out, uint32_t value, uint8_t bytes)
+{
+    for (uint8_t i = 0; i < bytes; ++i)
+    {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+static void AppendBig(std::vector<uint8_t>& out, uint32_t value, uint8_t bytes)
+{
+    for (int8_t i = bytes - 1; i >= 0; --i)
+    {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void WireCapture::Begin(std::vector<uint8_t>& out)
+{
+    if (format == Format::PCAP)
+    {
+        AppendLittle(out, 0xA1B2C3D4, 4);   // Microsecond timestamps
+        AppendLittle(out, 2, 2);
+        AppendLittle(out, 4, 2);
+        AppendLittle(out, 0, 4);            // UTC
+        AppendLittle(out, 0, 4);
+        AppendLittle(out, 65535, 4);
+        AppendLittle(out, RXBEE_CAPTURE_LINKTYPE, 4);
+    }
+}
+
+void WireCapture::AppendRecord(uint8_t direction, uint32_t time, Ring& ring, uint16_t len,
+                               std::vector<uint8_t>& out)
+{
+    if (format == Format::PCAP)
+    {
+        // The two rings are merged after the fact, a chunk stamped just
+        // before the last one written out keeps the same time
+        uint32_t delta = time - static_cast<uint32_t>(last_time);
+        if (!timed)
+        {
+            last_time = time;
+            timed = true;
+        }
+        else if (static_cast<int32_t>(delta) > 0)
+        {
+            last_time += delta;
+        }
+
+        AppendLittle(out, static_cast<uint32_t>(last_time / 1000000), 4);
+        AppendLittle(out, static_cast<uint32_t>(last_time % 1000000), 4);
+        AppendLittle(out, len + 1, 4);
+        AppendLittle(out, len + 1, 4);
+        out.push_back(direction);
+    }
+    else
+    {
+        out.push_back(direction);
+        AppendBig(out, time, 4);
+        AppendBig(out, len, 2);
+    }
+
+    ring.Read(out);
+}
+
+uint32_t WireCapture::Drain(std::vector<uint8_t>& out, uint32_t max_bytes)
+{
+    uint32_t count = 0;
+    size_t start = out.size();
+    bool more = true;
+
+    while (more && (out.size() - start < max_bytes))
+    {
+        uint32_t rx_time = 0;
+        uint32_t tx_time = 0;
+        uint16_t rx_len = 0;
+        uint16_t tx_len = 0;
+        bool rx = rings[RXBEE_CAPTURE_RX].Peek(rx_time, rx_len);
+        bool tx = rings[RXBEE_CAPTURE_TX].Peek(tx_time, tx_len);
+
+        if (rx && (!tx || (static_cast<int32_t>(rx_time - tx_time) <= 0)))
+        {
+            AppendRecord(RXBEE_CAPTURE_RX, rx_time, rings[RXBEE_CAPTURE_RX], rx_len, out);
+            count++;
+        }
+        else if (tx)
+        {
+            AppendRecord(RXBEE_CAPTURE_TX, tx_time, rings[RXBEE_CAPTURE_TX], tx_len, out);
+            count++;
+        }
+        else
+        {
+            more = false;
+        }
+    }
+
+    return count;
+}
+
+} // namespace RXBee
@@ -0,0 +1,106 @@
+#ifndef RXBEE_WIRE_CAPTURE_H
+#define RXBEE_WIRE_CAPTURE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "RXBee_Config.h"
+#include "SpscRing.h"
+#include "Metrics.h"
+
+#ifndef RXBEE_CAPTURE_RING_SIZE
+    #define RXBEE_CAPTURE_RING_SIZE     (8192)  // Bytes per direction, power of two up to 32768
+#endif
+
+#define RXBEE_CAPTURE_RX                (0)     // Radio to host
+#define RXBEE_CAPTURE_TX                (1)     // Host to radio
+#define RXBEE_CAPTURE_LINKTYPE          (147)   // LINKTYPE_USER0, direction byte then data
+
+namespace RXBee
+{
+
+// Records the raw serial chunks crossing the UART, as passed to
+// XBeeNetwork::OnNext and written to the SerialDataSubject, each with a
+// timestamp. Every direction has its own preallocated ring with a single
+// writer, so recording is a clock read and a copy without locks. A chunk
+// that does not fit is dropped and counted.
+//
+// Drain merges both directions in time order, as a pcap file (a link type
+// 147 packet per chunk, a direction byte before the data) or as length
+// prefixed records:
+//
+//   [direction] [microseconds, 32 bit] [length, 16 bit] [data]
+//
+// both big endian. Drain belongs to one thread, any thread but the writers
+// is fine.
+//
+//   WireCapture capture(ReadCoreTimerMicroseconds);
+//   net.SetCapture(&capture);
+class WireCapture
+{
+public:
+    typedef uint32_t (*Clock)(void);
+
+    enum class Format
+    {
+        PCAP,
+        LENGTH_PREFIXED
+    };
+
+    WireCapture(Clock clock);
+
+    void SetFormat(Format format);
+
+    void Record(uint8_t direction, const uint8_t* data, uint16_t len);
+
+    // Appends the file header of the format, if any, to out
+    void Begin(std::vector<uint8_t>& out);
+
+    // Appends captured chunks to out until about max_bytes were added or
+    // nothing is left, returns the number of chunks
+    uint32_t Drain(std::vector<uint8_t>& out, uint32_t max_bytes);
+
+    uint32_t GetDropped(uint8_t direction) const;
+
+private:
+    class Ring
+    {
+    public:
+        Ring();
+
+        bool Write(uint32_t time, const uint8_t* data, uint16_t len);
+
+        // Header of the oldest chunk, false when empty
+        bool Peek(uint32_t& time, uint16_t& len) const;
+
+        // Appends the data of the oldest chunk and releases it
+        void Read(std::vector<uint8_t>& out);
+
+        uint32_t GetDropped() const;
+
+    private:
+        void CopyIn(uint16_t index, const uint8_t* data, uint16_t len);
+
+        void CopyOut(uint16_t index, uint8_t* data, uint16_t len) const;
+
+        uint8_t buff[RXBEE_CAPTURE_RING_SIZE];
+
+        // Free running, masked on access
+        RXBEE_CACHE_ALIGNED RingIndex head;
+        RXBEE_CACHE_ALIGNED RingIndex tail;
+        Counter dropped;
+    };
+
+    void AppendRecord(uint8_t direction, uint32_t time, Ring& ring, uint16_t len,
+                      std::vector<uint8_t>& out);
+
+    Clock clock;
+    Format format;
+    Ring rings[2];
+    uint64_t last_time;     // Extends the 32 bit timestamps for pcap
+    bool timed;
+};
+
+} // namespace RXBee
+
+#endif // RXBEE_WIRE_CAPTURE_H